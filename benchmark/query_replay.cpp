@@ -0,0 +1,201 @@
+// Replays a recorded query log against an index built from a corpus file.
+// Build from the repository root:
+//     g++ -std=c++17 -O2 -I search-server benchmark/query_replay.cpp $(ls search-server/*.cpp | grep -v main.cpp) -ltbb -lpthread -o query_replay
+// Corpus format is described in corpus_loader.h, the query log holds one raw query per line.
+// Synthetic inputs can be produced with search_benchmark --write-corpus PATH --write-queries PATH.
+
+#include "corpus_loader.h"
+#include "mapped_file.h"
+#include "query_stage_times.h"
+#include "search_server.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <execution>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    using Clock = chrono::steady_clock;
+
+    struct ReplayOptions
+    {
+        string corpus_path;
+        string queries_path;
+        string stop_words;
+        // Folded stacks for flamegraph.pl, empty if not needed
+        string stages_path;
+        size_t thread_count = 1;
+        SearchServerOptions server;
+        // Queries per second over all threads, 0 replays as fast as possible
+        double rate = 0.0;
+        size_t repeat = 1;
+        bool parallel_policy = false;
+    };
+
+    struct ThreadReport
+    {
+        vector<int64_t> latencies_ns;
+        QueryStageTimes stage_times;
+        size_t found_documents = 0;
+    };
+
+    void PrintUsage()
+    {
+        cerr << "Usage: query_replay --corpus PATH --queries PATH [--stop-words \"WORDS\"] [--threads N]\n"s
+             << "                    [--server-threads N] [--rate QPS] [--repeat N] [--policy seq|par] [--stages PATH]"s << endl;
+    }
+
+    bool ParseOptions(int argc, char* argv[], ReplayOptions& options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const string_view name = argv[i];
+            if (i + 1 >= argc)
+            {
+                return false;
+            }
+            const char* value = argv[++i];
+            if (name == "--corpus"sv) options.corpus_path = value;
+            else if (name == "--queries"sv) options.queries_path = value;
+            else if (name == "--stop-words"sv) options.stop_words = value;
+            else if (name == "--stages"sv) options.stages_path = value;
+            else if (name == "--threads"sv) options.thread_count = max<size_t>(1, strtoull(value, nullptr, 10));
+            else if (name == "--server-threads"sv) options.server.thread_count = strtoull(value, nullptr, 10);
+            else if (name == "--rate"sv) options.rate = strtod(value, nullptr);
+            else if (name == "--repeat"sv) options.repeat = max<size_t>(1, strtoull(value, nullptr, 10));
+            else if (name == "--policy"sv) options.parallel_policy = (value == "par"sv);
+            else return false;
+        }
+        return !options.corpus_path.empty() && !options.queries_path.empty();
+    }
+
+    int64_t GetPercentile(const vector<int64_t>& sorted_values, double percentile)
+    {
+        if (sorted_values.empty())
+        {
+            return 0;
+        }
+        const size_t rank = static_cast<size_t>(percentile / 100.0 * static_cast<double>(sorted_values.size() - 1) + 0.5);
+        return sorted_values[min(rank, sorted_values.size() - 1)];
+    }
+
+    void WriteFoldedStacks(const string& path, const QueryStageTimes& times)
+    {
+        // Weights are microseconds summed over all threads
+        ofstream out(path);
+        out << "replay;FindTopDocuments;ParseQuery "s << chrono::duration_cast<chrono::microseconds>(times.parse).count() << '\n'
+            << "replay;FindTopDocuments;FindAllDocuments "s << chrono::duration_cast<chrono::microseconds>(times.score).count() << '\n'
+            << "replay;FindTopDocuments;SortAndTruncate "s << chrono::duration_cast<chrono::microseconds>(times.rank).count() << '\n';
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    ReplayOptions options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    SearchServer search_server(options.stop_words, options.server);
+    const auto build_start = Clock::now();
+    size_t document_count = 0;
+    {
+        const MappedFile corpus(options.corpus_path);
+        document_count = options.parallel_policy
+            ? LoadCorpus(execution::par, search_server, corpus.GetContent())
+            : LoadCorpus(execution::seq, search_server, corpus.GetContent());
+    }
+    const auto build_duration = Clock::now() - build_start;
+
+    const MappedFile query_log(options.queries_path);
+    const vector<string_view> log_queries = SplitIntoLines(query_log.GetContent());
+    const size_t total_queries = log_queries.size() * options.repeat;
+
+    vector<ThreadReport> reports(options.thread_count);
+    atomic<size_t> next_query = 0;
+    const auto replay_start = Clock::now();
+    {
+        vector<thread> threads;
+        for (ThreadReport& report : reports)
+        {
+            threads.emplace_back([&]
+            {
+                QueryStageRecorder recorder(report.stage_times);
+                for (size_t index = next_query++; index < total_queries; index = next_query++)
+                {
+                    // Under a target rate latency counts from the scheduled send time, so that a stall
+                    // delays the following queries and shows up in their latency too
+                    auto start = Clock::now();
+                    if (options.rate > 0.0)
+                    {
+                        start = replay_start + chrono::duration_cast<Clock::duration>(chrono::duration<double>(index / options.rate));
+                        this_thread::sleep_until(start);
+                    }
+                    const string_view query = log_queries[index % log_queries.size()];
+                    const size_t found = options.parallel_policy
+                        ? search_server.FindTopDocuments(execution::par, query).size()
+                        : search_server.FindTopDocuments(execution::seq, query).size();
+                    report.latencies_ns.push_back(chrono::duration_cast<chrono::nanoseconds>(Clock::now() - start).count());
+                    report.found_documents += found;
+                }
+            });
+        }
+        for (thread& worker : threads)
+        {
+            worker.join();
+        }
+    }
+    const auto replay_duration = Clock::now() - replay_start;
+
+    vector<int64_t> latencies;
+    QueryStageTimes stage_times;
+    size_t found_documents = 0;
+    for (const ThreadReport& report : reports)
+    {
+        latencies.insert(latencies.end(), report.latencies_ns.begin(), report.latencies_ns.end());
+        stage_times.parse += report.stage_times.parse;
+        stage_times.score += report.stage_times.score;
+        stage_times.rank += report.stage_times.rank;
+        stage_times.queries += report.stage_times.queries;
+        found_documents += report.found_documents;
+    }
+    sort(latencies.begin(), latencies.end());
+    const double replay_seconds = chrono::duration<double>(replay_duration).count();
+
+    if (!options.stages_path.empty())
+    {
+        WriteFoldedStacks(options.stages_path, stage_times);
+    }
+
+    cout << "{\n"s
+         << "  \"documents\": "s << document_count << ",\n"s
+         << "  \"build_ms\": "s << chrono::duration_cast<chrono::milliseconds>(build_duration).count() << ",\n"s
+         << "  \"threads\": "s << options.thread_count << ",\n"s
+         << "  \"policy\": \""s << (options.parallel_policy ? "par"s : "seq"s) << "\",\n"s
+         << "  \"target_qps\": "s << options.rate << ",\n"s
+         << "  \"queries\": "s << latencies.size() << ",\n"s
+         << "  \"found_documents\": "s << found_documents << ",\n"s
+         << "  \"qps\": "s << (replay_seconds > 0.0 ? static_cast<double>(latencies.size()) / replay_seconds : 0.0) << ",\n"s
+         << "  \"latency_ns\": { \"p50\": "s << GetPercentile(latencies, 50.0)
+         << ", \"p90\": "s << GetPercentile(latencies, 90.0)
+         << ", \"p99\": "s << GetPercentile(latencies, 99.0)
+         << ", \"p99.9\": "s << GetPercentile(latencies, 99.9)
+         << ", \"max\": "s << (latencies.empty() ? 0 : latencies.back()) << " },\n"s
+         << "  \"server_thread_utilization\": "s << search_server.GetThreadPool().GetStats().GetUtilization() << ",\n"s
+         << "  \"stages_ns\": { \"parse\": "s << stage_times.parse.count()
+         << ", \"score\": "s << stage_times.score.count()
+         << ", \"rank\": "s << stage_times.rank.count() << " }\n"s
+         << "}"s << endl;
+    return 0;
+}
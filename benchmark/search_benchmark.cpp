@@ -0,0 +1,664 @@
+// Benchmark suite for SearchServer on a seeded synthetic corpus.
+// Build from the repository root:
+//     g++ -std=c++17 -O2 -I search-server benchmark/search_benchmark.cpp $(ls search-server/*.cpp | grep -v main.cpp) -ltbb -lpthread -o search_benchmark
+// Results are printed to stdout as one JSON document; run with --help for the list of options.
+
+#include "corpus_loader.h"
+#include "document.h"
+#include "paginator.h"
+#include "process_queries.h"
+#include "remove_duplicates.h"
+#include "search_server.h"
+#include "segmented_index.h"
+#include "synthetic_corpus.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <execution>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    struct BenchmarkOptions
+    {
+        CorpusConfig corpus;
+        QueryConfig queries;
+        SearchServerOptions server;
+        size_t remove_count = 1000;
+        size_t repeat = 3;
+        // When set, the generated corpus and queries are written for query_replay instead of benchmarking
+        string corpus_path;
+        string queries_path;
+    };
+
+    struct BenchmarkResult
+    {
+        string name;
+        size_t operations = 0;
+        // Best of the repeats
+        int64_t total_ns = 0;
+        uint64_t checksum = 0;
+    };
+
+    // Resident set size of the process, 0 when it can not be determined
+    int64_t GetResidentBytes()
+    {
+#ifdef __linux__
+        ifstream statm("/proc/self/statm"s);
+        int64_t total_pages = 0;
+        int64_t resident_pages = 0;
+        if (statm >> total_pages >> resident_pages)
+        {
+            return resident_pages * 4096;
+        }
+#endif
+        return 0;
+    }
+
+    unique_ptr<SearchServer> BuildServer(const SyntheticCorpus& corpus, const SearchServerOptions& server_options)
+    {
+        auto search_server = make_unique<SearchServer>(corpus.stop_words, server_options);
+        for (const SyntheticDocument& document : corpus.documents)
+        {
+            search_server->AddDocument(document.id, document.text, document.status, document.ratings);
+        }
+        return search_server;
+    }
+
+    void WriteReplayInput(const SyntheticCorpus& corpus, const vector<string>& queries, const BenchmarkOptions& options)
+    {
+        ofstream corpus_out(options.corpus_path);
+        for (const SyntheticDocument& document : corpus.documents)
+        {
+            WriteCorpusRecord(corpus_out, document.id, document.status, document.ratings, document.text);
+        }
+        ofstream queries_out(options.queries_path);
+        for (const string& query : queries)
+        {
+            queries_out << query << '\n';
+        }
+        cerr << "Stop words: "s << corpus.stop_words << endl;
+    }
+
+    uint64_t HashDocuments(const vector<Document>& documents)
+    {
+        uint64_t hash = documents.size();
+        for (const Document& document : documents)
+        {
+            hash = hash * 1000003 + static_cast<uint64_t>(document.id);
+        }
+        return hash;
+    }
+
+    string_view GetAllocationName(IndexAllocation allocation)
+    {
+        switch (allocation)
+        {
+        case IndexAllocation::POOL:
+            return "pool"sv;
+        case IndexAllocation::ARENA:
+            return "arena"sv;
+        default:
+            return "heap"sv;
+        }
+    }
+
+    bool ParseAllocation(string_view name, IndexAllocation& allocation)
+    {
+        for (const IndexAllocation candidate : { IndexAllocation::GLOBAL_HEAP, IndexAllocation::POOL, IndexAllocation::ARENA })
+        {
+            if (name == GetAllocationName(candidate))
+            {
+                allocation = candidate;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    string_view GetPrecisionName(ScorePrecision precision)
+    {
+        return precision == ScorePrecision::FLOAT ? "float"sv : "double"sv;
+    }
+
+    bool ParsePrecision(string_view name, ScorePrecision& precision)
+    {
+        for (const ScorePrecision candidate : { ScorePrecision::DOUBLE, ScorePrecision::FLOAT })
+        {
+            if (name == GetPrecisionName(candidate))
+            {
+                precision = candidate;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    string_view GetTextRetentionName(TextRetention retention)
+    {
+        switch (retention)
+        {
+        case TextRetention::NONE:
+            return "none"sv;
+        case TextRetention::COMPRESSED:
+            return "compressed"sv;
+        case TextRetention::MAPPED_FILE:
+            return "file"sv;
+        default:
+            return "plain"sv;
+        }
+    }
+
+    bool ParseTextRetention(string_view name, TextRetention& retention)
+    {
+        for (const TextRetention candidate : { TextRetention::NONE, TextRetention::PLAIN, TextRetention::COMPRESSED, TextRetention::MAPPED_FILE })
+        {
+            if (name == GetTextRetentionName(candidate))
+            {
+                retention = candidate;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    class BenchmarkRunner
+    {
+    public:
+        explicit BenchmarkRunner(size_t repeat)
+            : repeat_(repeat)
+        {
+        }
+
+        // prepare() runs outside of the measured interval, body() returns the checksum of its work
+        void Run(const string& name, size_t operations, const function<void()>& prepare, const function<uint64_t()>& body)
+        {
+            BenchmarkResult result{ name, operations, numeric_limits<int64_t>::max(), 0 };
+            for (size_t i = 0; i < repeat_; ++i)
+            {
+                prepare();
+                const auto start = chrono::steady_clock::now();
+                result.checksum = body();
+                const auto duration = chrono::steady_clock::now() - start;
+                result.total_ns = min<int64_t>(result.total_ns, chrono::duration_cast<chrono::nanoseconds>(duration).count());
+            }
+            cerr << name << ": "s << result.total_ns / 1000000 << " ms"s << endl;
+            results_.push_back(result);
+        }
+
+        void Run(const string& name, size_t operations, const function<uint64_t()>& body)
+        {
+            Run(name, operations, [] {}, body);
+        }
+
+        void AddMetric(const string& name, int64_t value)
+        {
+            metrics_.emplace_back(name, value);
+        }
+
+        void PrintJson(ostream& out, const BenchmarkOptions& options) const
+        {
+            out << "{\n"s;
+            out << "  \"config\": { \"seed\": "s << options.corpus.seed
+                << ", \"documents\": "s << options.corpus.document_count
+                << ", \"vocabulary\": "s << options.corpus.vocabulary_size
+                << ", \"zipf_exponent\": "s << options.corpus.zipf_exponent
+                << ", \"min_document_length\": "s << options.corpus.min_document_length
+                << ", \"max_document_length\": "s << options.corpus.max_document_length
+                << ", \"stop_word_ratio\": "s << options.corpus.stop_word_ratio
+                << ", \"duplicate_rate\": "s << options.corpus.duplicate_rate
+                << ", \"topics\": "s << options.corpus.topic_count
+                << ", \"queries\": "s << options.queries.query_count
+                << ", \"query_seed\": "s << options.queries.seed
+                << ", \"repeat\": "s << repeat_
+                << ", \"threads\": "s << options.server.thread_count
+                << ", \"allocation\": \""s << GetAllocationName(options.server.allocation)
+                << "\", \"huge_pages\": "s << options.server.use_huge_pages
+                << ", \"precision\": \""s << GetPrecisionName(options.server.score_precision)
+                << "\", \"text\": \""s << GetTextRetentionName(options.server.text_retention)
+                << "\", \"scoring_kernel\": \""s << GetScoringKernelName() << "\" },\n"s;
+            out << "  \"metrics\": {"s;
+            for (size_t i = 0; i < metrics_.size(); ++i)
+            {
+                out << (i == 0 ? " "s : ", "s) << "\""s << metrics_[i].first << "\": "s << metrics_[i].second;
+            }
+            out << " },\n"s;
+            out << "  \"results\": [\n"s;
+            for (size_t i = 0; i < results_.size(); ++i)
+            {
+                const BenchmarkResult& result = results_[i];
+                out << "    { \"name\": \""s << result.name
+                    << "\", \"operations\": "s << result.operations
+                    << ", \"total_ns\": "s << result.total_ns
+                    << ", \"ns_per_op\": "s << (result.operations ? result.total_ns / static_cast<int64_t>(result.operations) : 0)
+                    << ", \"checksum\": "s << result.checksum << " }"s
+                    << (i + 1 < results_.size() ? ",\n"s : "\n"s);
+            }
+            out << "  ]\n}"s << endl;
+        }
+
+    private:
+        size_t repeat_;
+        vector<BenchmarkResult> results_;
+        vector<pair<string, int64_t>> metrics_;
+    };
+
+    void PrintUsage()
+    {
+        cerr << "Usage: search_benchmark [--seed N] [--documents N] [--vocabulary N] [--zipf S]\n"s
+             << "                        [--min-length N] [--max-length N] [--stop-ratio R] [--duplicates R] [--topics N]\n"s
+             << "                        [--queries N] [--query-seed N] [--minus-rate R] [--remove N] [--repeat N] [--threads N]\n"s
+             << "                        [--allocation heap|pool|arena] [--huge-pages 0|1] [--precision double|float]\n"s
+             << "                        [--text none|plain|compressed|file] [--text-dir PATH]\n"s
+             << "                        [--write-corpus PATH --write-queries PATH]"s << endl;
+    }
+
+    bool ParseOptions(int argc, char* argv[], BenchmarkOptions& options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const string_view name = argv[i];
+            if (i + 1 >= argc)
+            {
+                return false;
+            }
+            const char* value = argv[++i];
+            if (name == "--seed"sv) options.corpus.seed = strtoull(value, nullptr, 10);
+            else if (name == "--documents"sv) options.corpus.document_count = strtoull(value, nullptr, 10);
+            else if (name == "--vocabulary"sv) options.corpus.vocabulary_size = strtoull(value, nullptr, 10);
+            else if (name == "--zipf"sv) options.corpus.zipf_exponent = strtod(value, nullptr);
+            else if (name == "--min-length"sv) options.corpus.min_document_length = strtoull(value, nullptr, 10);
+            else if (name == "--max-length"sv) options.corpus.max_document_length = strtoull(value, nullptr, 10);
+            else if (name == "--stop-ratio"sv) options.corpus.stop_word_ratio = strtod(value, nullptr);
+            else if (name == "--duplicates"sv) options.corpus.duplicate_rate = strtod(value, nullptr);
+            else if (name == "--topics"sv) options.corpus.topic_count = strtoull(value, nullptr, 10);
+            else if (name == "--queries"sv) options.queries.query_count = strtoull(value, nullptr, 10);
+            else if (name == "--query-seed"sv) options.queries.seed = strtoull(value, nullptr, 10);
+            else if (name == "--minus-rate"sv) options.queries.minus_query_rate = strtod(value, nullptr);
+            else if (name == "--remove"sv) options.remove_count = strtoull(value, nullptr, 10);
+            else if (name == "--threads"sv) options.server.thread_count = strtoull(value, nullptr, 10);
+            else if (name == "--allocation"sv)
+            {
+                if (!ParseAllocation(value, options.server.allocation))
+                {
+                    return false;
+                }
+            }
+            else if (name == "--precision"sv)
+            {
+                if (!ParsePrecision(value, options.server.score_precision))
+                {
+                    return false;
+                }
+            }
+            else if (name == "--text"sv)
+            {
+                if (!ParseTextRetention(value, options.server.text_retention))
+                {
+                    return false;
+                }
+            }
+            else if (name == "--text-dir"sv) options.server.text_file_directory = value;
+            else if (name == "--huge-pages"sv) options.server.use_huge_pages = strtoull(value, nullptr, 10) != 0;
+            else if (name == "--repeat"sv) options.repeat = max<size_t>(1, strtoull(value, nullptr, 10));
+            else if (name == "--write-corpus"sv) options.corpus_path = value;
+            else if (name == "--write-queries"sv) options.queries_path = value;
+            else return false;
+        }
+        return options.corpus.min_document_length > 0
+            && options.corpus.min_document_length <= options.corpus.max_document_length
+            && options.corpus.vocabulary_size > 0;
+    }
+
+    template <typename Search>
+    uint64_t RunQueries(const vector<string>& queries, Search search)
+    {
+        uint64_t checksum = 0;
+        for (const string& query : queries)
+        {
+            checksum = checksum * 31 + HashDocuments(search(query));
+        }
+        return checksum;
+    }
+
+    template <typename ExecutionPolicy>
+    void RunFindBenchmarks(BenchmarkRunner& runner, const string& policy_name, const ExecutionPolicy& policy,
+        const SearchServer& search_server, const vector<string>& queries)
+    {
+        runner.Run("FindTopDocuments/"s + policy_name + "/default"s, queries.size(), [&]
+        {
+            return RunQueries(queries, [&](const string& query) { return search_server.FindTopDocuments(policy, query); });
+        });
+        runner.Run("FindTopDocuments/"s + policy_name + "/status"s, queries.size(), [&]
+        {
+            return RunQueries(queries, [&](const string& query)
+                { return search_server.FindTopDocuments(policy, query, DocumentStatus::BANNED); });
+        });
+        runner.Run("FindTopDocuments/"s + policy_name + "/lambda"s, queries.size(), [&]
+        {
+            return RunQueries(queries, [&](const string& query)
+            {
+                return search_server.FindTopDocuments(policy, query,
+                    [](int document_id, DocumentStatus status, int rating) { return document_id % 2 == 0 && rating > 0; });
+            });
+        });
+    }
+
+    template <typename ExecutionPolicy>
+    void RunMatchBenchmark(BenchmarkRunner& runner, const string& policy_name, const ExecutionPolicy& policy,
+        const SearchServer& search_server, const vector<string>& queries)
+    {
+        const int document_count = search_server.GetDocumentCount();
+        runner.Run("MatchDocument/"s + policy_name, queries.size(), [&]
+        {
+            uint64_t checksum = 0;
+            int document_id = 0;
+            for (const string& query : queries)
+            {
+                const auto [words, status] = search_server.MatchDocument(policy, query, document_id);
+                checksum = checksum * 31 + words.size() + static_cast<uint64_t>(status);
+                document_id = (document_id + 7919) % document_count;
+            }
+            return checksum;
+        });
+
+        vector<int> document_ids;
+        for (int document_id = 0; document_id < document_count && document_ids.size() < 256; document_id += 7)
+        {
+            document_ids.push_back(document_id);
+        }
+        runner.Run("MatchDocuments/"s + policy_name + "/256"s, queries.size(), [&]
+        {
+            uint64_t checksum = 0;
+            for (const string& query : queries)
+            {
+                for (const auto& [words, status] : search_server.MatchDocuments(policy, query, document_ids))
+                {
+                    checksum = checksum * 31 + words.size() + static_cast<uint64_t>(status);
+                }
+            }
+            return checksum;
+        });
+    }
+
+    template <typename ExecutionPolicy>
+    void RunRemoveBenchmark(BenchmarkRunner& runner, const string& policy_name, const ExecutionPolicy& policy,
+        const SyntheticCorpus& corpus, const BenchmarkOptions& options)
+    {
+        const size_t remove_count = options.remove_count;
+        unique_ptr<SearchServer> search_server;
+        runner.Run("RemoveDocument/"s + policy_name, remove_count,
+            [&] { search_server = BuildServer(corpus, options.server); },
+            [&]
+            {
+                for (size_t i = 0; i < remove_count; ++i)
+                {
+                    search_server->RemoveDocument(policy, corpus.documents[i * corpus.documents.size() / remove_count].id);
+                }
+                return static_cast<uint64_t>(search_server->GetDocumentCount());
+            });
+
+        vector<int> document_ids;
+        for (size_t i = 0; i < remove_count; ++i)
+        {
+            document_ids.push_back(corpus.documents[i * corpus.documents.size() / remove_count].id);
+        }
+        runner.Run("RemoveDocuments/"s + policy_name, remove_count,
+            [&] { search_server = BuildServer(corpus, options.server); },
+            [&]
+            {
+                search_server->RemoveDocuments(policy, document_ids);
+                return static_cast<uint64_t>(search_server->GetDocumentCount());
+            });
+    }
+
+    void RunSegmentedBenchmarks(BenchmarkRunner& runner, const SyntheticCorpus& corpus, const vector<string>& queries,
+        const BenchmarkOptions& options)
+    {
+        SegmentedIndexOptions index_options;
+        index_options.thread_count = options.server.thread_count;
+        unique_ptr<SegmentedIndex> index;
+        // Includes the merges still running when the last document is added
+        runner.Run("SegmentedIndex/AddDocument"s, corpus.documents.size(), [&] { index.reset(); }, [&]
+        {
+            index = make_unique<SegmentedIndex>(corpus.stop_words, index_options);
+            for (const SyntheticDocument& document : corpus.documents)
+            {
+                index->AddDocument(document.id, document.text, document.status, document.ratings);
+            }
+            index->WaitForMerges();
+            return static_cast<uint64_t>(index->GetDocumentCount());
+        });
+        const SegmentedIndex::Stats stats = index->GetStats();
+        runner.AddMetric("segmented_index_segments"s, static_cast<int64_t>(stats.segment_count));
+        runner.AddMetric("segmented_index_merges"s, static_cast<int64_t>(stats.merge_count));
+        runner.AddMetric("segmented_index_term_filter_false_positive_ppm"s, static_cast<int64_t>(stats.term_filter_false_positive_rate * 1e6));
+
+        runner.Run("SegmentedIndex/FindTopDocuments/seq"s, queries.size(), [&]
+        {
+            return RunQueries(queries, [&](const string& query) { return index->FindTopDocuments(execution::seq, query); });
+        });
+        runner.Run("SegmentedIndex/FindTopDocuments/par"s, queries.size(), [&]
+        {
+            return RunQueries(queries, [&](const string& query) { return index->FindTopDocuments(execution::par, query); });
+        });
+
+        // One segment in the order of ids, then in the order of the bisection: same results, smaller gaps
+        for (const auto& [order, name] : { pair{ DocumentOrder::BY_ID, "by_id"s }, pair{ DocumentOrder::LOCALITY, "locality"s } })
+        {
+            runner.Run("SegmentedIndex/Optimize/"s + name, corpus.documents.size(), [&]
+            {
+                index->Optimize(order);
+                return static_cast<uint64_t>(index->GetDocumentCount());
+            });
+            runner.AddMetric("segmented_index_posting_bytes_"s + name, static_cast<int64_t>(index->GetStats().posting_bytes));
+            runner.Run("SegmentedIndex/FindTopDocuments/seq/"s + name, queries.size(), [&]
+            {
+                return RunQueries(queries, [&](const string& query) { return index->FindTopDocuments(execution::seq, query); });
+            });
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    BenchmarkOptions options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        PrintUsage();
+        return 1;
+    }
+    options.remove_count = min(options.remove_count, options.corpus.document_count);
+
+    const SyntheticCorpus corpus = GenerateCorpus(options.corpus);
+    const vector<string> queries = GenerateQueries(corpus, options.queries);
+    if (!options.corpus_path.empty() || !options.queries_path.empty())
+    {
+        if (options.corpus_path.empty() || options.queries_path.empty())
+        {
+            PrintUsage();
+            return 1;
+        }
+        WriteReplayInput(corpus, queries, options);
+        return 0;
+    }
+    BenchmarkRunner runner(options.repeat);
+
+    // Measured on the first build only: later builds reuse memory the allocator keeps after the previous one
+    const int64_t resident_before = GetResidentBytes();
+    unique_ptr<SearchServer> search_server = BuildServer(corpus, options.server);
+    const int64_t resident_bytes = GetResidentBytes() - resident_before;
+    runner.AddMetric("resident_bytes"s, resident_bytes);
+    runner.AddMetric("resident_bytes_per_document"s,
+        corpus.documents.empty() ? 0 : resident_bytes / static_cast<int64_t>(corpus.documents.size()));
+
+    // Estimate of the server by structure, to compare with the resident size above
+    const MemoryUsage memory_usage = search_server->GetMemoryUsage();
+    size_t posting_count = 0;
+    for (const int document_id : *search_server)
+    {
+        posting_count += search_server->GetWordFrequencies(document_id).size();
+    }
+    const int64_t document_count = max<int64_t>(1, static_cast<int64_t>(corpus.documents.size()));
+    runner.AddMetric("memory_stop_words_bytes"s, static_cast<int64_t>(memory_usage.stop_words));
+    runner.AddMetric("memory_dictionary_bytes"s, static_cast<int64_t>(memory_usage.dictionary));
+    runner.AddMetric("memory_postings_bytes"s, static_cast<int64_t>(memory_usage.postings));
+    runner.AddMetric("memory_forward_index_bytes"s, static_cast<int64_t>(memory_usage.forward_index));
+    runner.AddMetric("memory_document_metadata_bytes"s, static_cast<int64_t>(memory_usage.document_metadata));
+    runner.AddMetric("memory_document_text_bytes"s, static_cast<int64_t>(memory_usage.document_text));
+    runner.AddMetric("memory_index_resource_bytes"s, static_cast<int64_t>(memory_usage.index_resource));
+    runner.AddMetric("memory_total_bytes"s, static_cast<int64_t>(memory_usage.GetTotal()));
+    runner.AddMetric("memory_bytes_per_document"s, static_cast<int64_t>(memory_usage.GetTotal()) / document_count);
+    runner.AddMetric("memory_postings_bytes_per_posting_x100"s,
+        posting_count == 0 ? 0 : static_cast<int64_t>(memory_usage.postings * 100 / posting_count));
+
+    const TermFilter::Stats filter_stats = search_server->GetTermFilterStats();
+    runner.AddMetric("term_filter_bytes"s, static_cast<int64_t>(filter_stats.byte_size));
+    runner.AddMetric("term_filter_false_positive_ppm"s, static_cast<int64_t>(filter_stats.false_positive_rate * 1e6));
+
+    runner.Run("AddDocument"s, corpus.documents.size(), [&] { search_server.reset(); }, [&]
+    {
+        search_server = BuildServer(corpus, options.server);
+        return static_cast<uint64_t>(search_server->GetDocumentCount());
+    });
+
+    // Same build from the corpus file format, as query_replay reads it; the index is the same as the one built above
+    ostringstream corpus_out;
+    for (const SyntheticDocument& document : corpus.documents)
+    {
+        WriteCorpusRecord(corpus_out, document.id, document.status, document.ratings, document.text);
+    }
+    const string corpus_text = corpus_out.str();
+    runner.Run("LoadCorpus/seq"s, corpus.documents.size(), [&] { search_server.reset(); }, [&]
+    {
+        search_server = make_unique<SearchServer>(corpus.stop_words, options.server);
+        return static_cast<uint64_t>(LoadCorpus(execution::seq, *search_server, corpus_text));
+    });
+    runner.Run("LoadCorpus/par"s, corpus.documents.size(), [&] { search_server.reset(); }, [&]
+    {
+        search_server = make_unique<SearchServer>(corpus.stop_words, options.server);
+        return static_cast<uint64_t>(LoadCorpus(execution::par, *search_server, corpus_text));
+    });
+
+    // Teardown of a whole index: node by node on the global heap, at once for pools and arenas
+    unique_ptr<SearchServer> destroyed_server;
+    runner.Run("DestroyServer"s, corpus.documents.size(), [&] { destroyed_server = BuildServer(corpus, options.server); }, [&]
+    {
+        destroyed_server.reset();
+        return uint64_t{ 0 };
+    });
+
+    RunFindBenchmarks(runner, "seq"s, execution::seq, *search_server, queries);
+    RunFindBenchmarks(runner, "par"s, execution::par, *search_server, queries);
+
+    runner.Run("BuildImpactIndex"s, corpus.documents.size(), [&]
+    {
+        search_server->BuildImpactIndex();
+        return static_cast<uint64_t>(search_server->GetMemoryUsage().impact_index);
+    });
+    runner.AddMetric("memory_impact_index_bytes"s, static_cast<int64_t>(search_server->GetMemoryUsage().impact_index));
+    // Same checksums as FindTopDocuments/seq with --precision double
+    runner.Run("FindTopDocumentsByImpact/default"s, queries.size(), [&]
+    {
+        return RunQueries(queries, [&](const string& query) { return search_server->FindTopDocumentsByImpact(query); });
+    });
+    runner.Run("FindTopDocumentsByImpact/status"s, queries.size(), [&]
+    {
+        return RunQueries(queries, [&](const string& query)
+            { return search_server->FindTopDocumentsByImpact(query, DocumentStatus::BANNED); });
+    });
+    runner.Run("FindTopDocumentsByImpact/lambda"s, queries.size(), [&]
+    {
+        return RunQueries(queries, [&](const string& query)
+        {
+            return search_server->FindTopDocumentsByImpact(query,
+                [](int document_id, DocumentStatus status, int rating) { return document_id % 2 == 0 && rating > 0; });
+        });
+    });
+    if (!corpus.documents.empty())
+    {
+        RunMatchBenchmark(runner, "seq"s, execution::seq, *search_server, queries);
+        RunMatchBenchmark(runner, "par"s, execution::par, *search_server, queries);
+    }
+    if (options.server.text_retention != TextRetention::NONE)
+    {
+        // Ids in a scattered order, as the results of queries would ask for them
+        runner.Run("GetDocumentText"s, corpus.documents.size(), [&]
+        {
+            uint64_t checksum = 0;
+            for (size_t i = 0; i < corpus.documents.size(); ++i)
+            {
+                const string text = search_server->GetDocumentText(corpus.documents[i * 7919 % corpus.documents.size()].id);
+                checksum = checksum * 31 + text.size();
+            }
+            return checksum;
+        });
+    }
+
+    runner.Run("PaginateSearch/10x10"s, queries.size(), [&]
+    {
+        uint64_t checksum = 0;
+        for (const string& query : queries)
+        {
+            size_t page_count = 0;
+            for (const auto& page : PaginateSearch(*search_server, query, 10))
+            {
+                checksum = checksum * 31 + HashDocuments(page);
+                if (++page_count == 10)
+                {
+                    break;
+                }
+            }
+        }
+        return checksum;
+    });
+
+    runner.Run("ProcessQueries"s, queries.size(), [&]
+    {
+        uint64_t checksum = 0;
+        for (const auto& documents : ProcessQueries(*search_server, queries))
+        {
+            checksum = checksum * 31 + HashDocuments(documents);
+        }
+        return checksum;
+    });
+
+    // Pool of the server used by all the search benchmarks above
+    const ThreadPool::Stats pool_stats = search_server->GetThreadPool().GetStats();
+    uint64_t stolen_tasks = 0;
+    for (const ThreadPool::WorkerStats& worker : pool_stats.workers)
+    {
+        stolen_tasks += worker.stolen_tasks;
+    }
+    runner.AddMetric("thread_pool_submitted_tasks"s, static_cast<int64_t>(pool_stats.submitted_tasks));
+    runner.AddMetric("thread_pool_stolen_tasks"s, static_cast<int64_t>(stolen_tasks));
+
+    RunRemoveBenchmark(runner, "seq"s, execution::seq, corpus, options);
+    RunRemoveBenchmark(runner, "par"s, execution::par, corpus, options);
+
+    runner.Run("RemoveDuplicates"s, corpus.documents.size(),
+        [&] { search_server = BuildServer(corpus, options.server); },
+        [&]
+        {
+            // RemoveDuplicates reports every duplicate to cout, keep stdout clean for the JSON
+            ostringstream discarded;
+            auto* const cout_buffer = cout.rdbuf(discarded.rdbuf());
+            RemoveDuplicates(*search_server);
+            cout.rdbuf(cout_buffer);
+            return static_cast<uint64_t>(search_server->GetDocumentCount());
+        });
+
+    RunSegmentedBenchmarks(runner, corpus, queries, options);
+
+    runner.PrintJson(cout, options);
+    return 0;
+}
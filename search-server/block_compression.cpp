@@ -0,0 +1,187 @@
+#include "block_compression.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+    constexpr size_t MIN_MATCH = 4;
+    constexpr size_t MAX_OFFSET = 0xFFFF;
+    constexpr size_t HASH_BITS = 13;
+    // Short literals and matches are copied as one fixed-size chunk, which may write past their end
+    constexpr size_t COPY_CHUNK = 16;
+
+    uint32_t Load32(const char* data)
+    {
+        uint32_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    size_t Hash(uint32_t sequence)
+    {
+        return (sequence * 2654435761u) >> (32 - HASH_BITS);
+    }
+
+    void WriteLength(std::string& out, size_t length)
+    {
+        for (; length >= 255; length -= 255)
+        {
+            out += static_cast<char>(255);
+        }
+        out += static_cast<char>(length);
+    }
+
+    // Match length 0 marks the last sequence, which has no offset
+    void WriteSequence(std::string& out, std::string_view literals, size_t offset, size_t match_length)
+    {
+        const size_t match_code = match_length == 0 ? 0 : match_length - MIN_MATCH;
+        out += static_cast<char>((std::min<size_t>(literals.size(), 15) << 4) | std::min<size_t>(match_code, 15));
+        if (literals.size() >= 15)
+        {
+            WriteLength(out, literals.size() - 15);
+        }
+        out += literals;
+        if (match_length == 0)
+        {
+            return;
+        }
+        out += static_cast<char>(offset & 0xFF);
+        out += static_cast<char>(offset >> 8);
+        if (match_code >= 15)
+        {
+            WriteLength(out, match_code - 15);
+        }
+    }
+
+    size_t ReadLength(std::string_view compressed, size_t& position)
+    {
+        using namespace std::string_literals;
+        size_t length = 0;
+        uint8_t byte = 255;
+        while (byte == 255)
+        {
+            if (position == compressed.size())
+            {
+                throw std::runtime_error("Compressed block is truncated"s);
+            }
+            byte = static_cast<uint8_t>(compressed[position++]);
+            length += byte;
+        }
+        return length;
+    }
+}
+
+std::string CompressBlock(std::string_view data)
+{
+    std::string out;
+    out.reserve(data.size() + data.size() / 255 + 16);
+    // Position + 1 of the last sequence with the hash, 0 for none
+    std::vector<uint32_t> table(size_t{ 1 } << HASH_BITS, 0);
+    size_t anchor = 0;
+    size_t position = 0;
+    while (position + MIN_MATCH <= data.size())
+    {
+        const uint32_t sequence = Load32(data.data() + position);
+        uint32_t& entry = table[Hash(sequence)];
+        const size_t candidate = entry;
+        entry = static_cast<uint32_t>(position + 1);
+        if (candidate == 0 || position + 1 - candidate > MAX_OFFSET || Load32(data.data() + candidate - 1) != sequence)
+        {
+            ++position;
+            continue;
+        }
+        const size_t match = candidate - 1;
+        size_t length = MIN_MATCH;
+        while (position + length < data.size() && data[match + length] == data[position + length])
+        {
+            ++length;
+        }
+        WriteSequence(out, data.substr(anchor, position - anchor), position - match, length);
+        position += length;
+        anchor = position;
+    }
+    WriteSequence(out, data.substr(anchor), 0, 0);
+    return out;
+}
+
+std::string DecompressBlock(std::string_view compressed, size_t raw_size)
+{
+    using namespace std::string_literals;
+    std::string out(raw_size + COPY_CHUNK, '\0');
+    char* const begin = out.data();
+    char* end = begin;
+    // The chunk copies may go past out_end, but never past the end of the buffer
+    const char* const out_end = begin + raw_size;
+    size_t position = 0;
+    while (position < compressed.size())
+    {
+        const uint8_t token = static_cast<uint8_t>(compressed[position++]);
+        size_t literal_length = token >> 4;
+        if (literal_length == 15)
+        {
+            literal_length += ReadLength(compressed, position);
+        }
+        if (literal_length > compressed.size() - position || literal_length > static_cast<size_t>(out_end - end))
+        {
+            throw std::runtime_error("Compressed block is damaged"s);
+        }
+        if (literal_length <= COPY_CHUNK && compressed.size() - position >= COPY_CHUNK)
+        {
+            std::memcpy(end, compressed.data() + position, COPY_CHUNK);
+        }
+        else
+        {
+            std::memcpy(end, compressed.data() + position, literal_length);
+        }
+        end += literal_length;
+        position += literal_length;
+        if (position == compressed.size())
+        {
+            break;
+        }
+
+        if (compressed.size() - position < 2)
+        {
+            throw std::runtime_error("Compressed block is truncated"s);
+        }
+        const size_t offset = static_cast<uint8_t>(compressed[position]) | (static_cast<size_t>(static_cast<uint8_t>(compressed[position + 1])) << 8);
+        position += 2;
+        size_t match_length = (token & 0x0F) + MIN_MATCH;
+        if ((token & 0x0F) == 15)
+        {
+            match_length += ReadLength(compressed, position);
+        }
+        if (offset == 0 || offset > static_cast<size_t>(end - begin) || match_length > static_cast<size_t>(out_end - end))
+        {
+            throw std::runtime_error("Compressed block is damaged"s);
+        }
+        const char* match = end - offset;
+        if (match_length <= COPY_CHUNK && offset >= COPY_CHUNK)
+        {
+            std::memcpy(end, match, COPY_CHUNK);
+            end += match_length;
+        }
+        else if (offset >= match_length)
+        {
+            std::memcpy(end, match, match_length);
+            end += match_length;
+        }
+        else
+        {
+            // The match overlaps the bytes it produces: a run repeating the last `offset` bytes
+            for (size_t i = 0; i < match_length; ++i)
+            {
+                *end++ = *match++;
+            }
+        }
+    }
+    if (end != out_end)
+    {
+        throw std::runtime_error("Compressed block is damaged"s);
+    }
+    out.resize(raw_size);
+    return out;
+}
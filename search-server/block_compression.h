@@ -0,0 +1,13 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+// LZ77 coder in the manner of the LZ4 block format: a sequence is a token byte with 4 bits of literal length
+// and 4 bits of match length, the literals, and a 2-byte offset of the match within the previous 64 KiB.
+// Lengths that do not fit the token continue in bytes of 255. The last sequence holds literals only.
+// Fast rather than compact: one hash probe per position, no entropy coding.
+
+std::string CompressBlock(std::string_view data);
+
+// raw_size: size of the data before compression; runtime_error if the block is damaged
+std::string DecompressBlock(std::string_view compressed, size_t raw_size);
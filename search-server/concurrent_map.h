@@ -53,6 +53,7 @@ public:
     {
         auto index = static_cast<uint64_t>(key) % buckets_.size();
         auto& bucket = buckets_[index];
+        std::lock_guard g(bucket.mutex);
         auto it = bucket.map.find(key);
         if (it != bucket.map.end())
         {
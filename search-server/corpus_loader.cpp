@@ -0,0 +1,152 @@
+#include "corpus_loader.h"
+#include <charconv>
+#include <stdexcept>
+
+namespace
+{
+    std::string_view NextField(std::string_view& line)
+    {
+        using namespace std::string_literals;
+        const size_t tab = line.find('\t');
+        if (tab == line.npos)
+        {
+            throw std::invalid_argument("Corpus record has too few fields"s);
+        }
+        const std::string_view field = line.substr(0, tab);
+        line.remove_prefix(tab + 1);
+        return field;
+    }
+
+    int ParseInt(std::string_view text)
+    {
+        using namespace std::string_literals;
+        int value = 0;
+        const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (error != std::errc() || end != text.data() + text.size())
+        {
+            throw std::invalid_argument("Corpus record contains an invalid number"s);
+        }
+        return value;
+    }
+
+    DocumentStatus ParseStatus(std::string_view text)
+    {
+        using namespace std::literals;
+        if (text == "ACTUAL"sv)
+        {
+            return DocumentStatus::ACTUAL;
+        }
+        if (text == "IRRELEVANT"sv)
+        {
+            return DocumentStatus::IRRELEVANT;
+        }
+        if (text == "BANNED"sv)
+        {
+            return DocumentStatus::BANNED;
+        }
+        if (text == "REMOVED"sv)
+        {
+            return DocumentStatus::REMOVED;
+        }
+        throw std::invalid_argument("Corpus record contains an unknown status"s);
+    }
+
+    std::string_view StatusToString(DocumentStatus status)
+    {
+        using namespace std::literals;
+        switch (status)
+        {
+        case DocumentStatus::ACTUAL:
+            return "ACTUAL"sv;
+        case DocumentStatus::IRRELEVANT:
+            return "IRRELEVANT"sv;
+        case DocumentStatus::BANNED:
+            return "BANNED"sv;
+        default:
+            return "REMOVED"sv;
+        }
+    }
+}
+
+std::vector<std::string_view> SplitIntoLines(std::string_view text)
+{
+    std::vector<std::string_view> lines;
+    while (!text.empty())
+    {
+        const size_t end = std::min(text.find('\n'), text.size());
+        std::string_view line = text.substr(0, end);
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.remove_suffix(1);
+        }
+        if (!line.empty())
+        {
+            lines.push_back(line);
+        }
+        text.remove_prefix(std::min(end + 1, text.size()));
+    }
+    return lines;
+}
+
+std::vector<std::string_view> SplitIntoChunks(std::string_view text, size_t chunk_size)
+{
+    std::vector<std::string_view> chunks;
+    while (!text.empty())
+    {
+        const size_t line_end = chunk_size < text.size() ? text.find('\n', chunk_size - 1) : text.npos;
+        const size_t end = line_end == text.npos ? text.size() : line_end + 1;
+        chunks.push_back(text.substr(0, end));
+        text.remove_prefix(end);
+    }
+    return chunks;
+}
+
+CorpusRecord ParseCorpusRecord(std::string_view line)
+{
+    CorpusRecord record;
+    record.id = ParseInt(NextField(line));
+    record.status = ParseStatus(NextField(line));
+    for (const std::string_view rating : SplitIntoWords(NextField(line)))
+    {
+        record.ratings.push_back(ParseInt(rating));
+    }
+    record.text = line;
+    return record;
+}
+
+std::vector<CorpusRecord> ParseCorpusRecords(std::string_view text)
+{
+    const std::vector<std::string_view> lines = SplitIntoLines(text);
+    std::vector<CorpusRecord> records;
+    records.reserve(lines.size());
+    for (const std::string_view line : lines)
+    {
+        records.push_back(ParseCorpusRecord(line));
+    }
+    return records;
+}
+
+void WriteCorpusRecord(std::ostream& out, int id, DocumentStatus status, const std::vector<int>& ratings, std::string_view text)
+{
+    out << id << '\t' << StatusToString(status) << '\t';
+    for (size_t i = 0; i < ratings.size(); ++i)
+    {
+        out << (i == 0 ? "" : " ") << ratings[i];
+    }
+    out << '\t' << text << '\n';
+}
+
+size_t LoadCorpus(SearchServer& search_server, std::string_view corpus)
+{
+    // Chunk by chunk, so the records of the whole corpus are never in memory at once
+    size_t document_count = 0;
+    for (const std::string_view chunk : SplitIntoChunks(corpus, CORPUS_CHUNK_SIZE))
+    {
+        for (const CorpusRecord& record : ParseCorpusRecords(chunk))
+        {
+            search_server.AddDocument(record.id, record.text, record.status, record.ratings);
+            ++document_count;
+        }
+    }
+    return document_count;
+}
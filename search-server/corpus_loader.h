@@ -0,0 +1,91 @@
+#pragma once
+#include "document.h"
+#include "search_server.h"
+#include <deque>
+#include <execution>
+#include <future>
+#include <iostream>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Corpus file holds one document per line:
+//     <id> TAB <status> TAB <ratings separated by spaces> TAB <text>
+// status is one of ACTUAL, IRRELEVANT, BANNED, REMOVED
+
+struct CorpusRecord
+{
+    int id = 0;
+    DocumentStatus status = DocumentStatus::ACTUAL;
+    std::vector<int> ratings;
+    std::string_view text;
+};
+
+// Pieces of the corpus processed by one task of the parallel LoadCorpus
+constexpr size_t CORPUS_CHUNK_SIZE = size_t{ 1 } << 20;
+
+// Non-empty lines without the trailing '\r'
+std::vector<std::string_view> SplitIntoLines(std::string_view text);
+
+// Consecutive pieces of about chunk_size bytes, each one ends with a whole line
+std::vector<std::string_view> SplitIntoChunks(std::string_view text, size_t chunk_size);
+
+CorpusRecord ParseCorpusRecord(std::string_view line);
+
+// Records of every non-empty line; their texts point into `text`
+std::vector<CorpusRecord> ParseCorpusRecords(std::string_view text);
+
+void WriteCorpusRecord(std::ostream& out, int id, DocumentStatus status, const std::vector<int>& ratings, std::string_view text);
+
+// Adds every record of the corpus to the server, returns the number of added documents.
+// The texts go to AddDocument as views of the corpus, which is never copied as a whole
+size_t LoadCorpus(SearchServer& search_server, std::string_view corpus);
+
+// execution::par parses the chunks on the thread pool of the server, ahead of the calling thread,
+// which adds the parsed records in the order of the corpus: indexing is still sequential
+template <typename ExecutionPolicy>
+size_t LoadCorpus(const ExecutionPolicy& policy, SearchServer& search_server, std::string_view corpus)
+{
+    if constexpr (std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::sequenced_policy>)
+    {
+        return LoadCorpus(search_server, corpus);
+    }
+    else
+    {
+        ThreadPool& thread_pool = search_server.GetThreadPool();
+        const std::vector<std::string_view> chunks = SplitIntoChunks(corpus, CORPUS_CHUNK_SIZE);
+        // Parsed records wait in memory for a few chunks at most
+        const size_t parsed_ahead = 2 * thread_pool.GetThreadCount() + 1;
+        std::deque<std::future<std::vector<CorpusRecord>>> parsed_chunks;
+        size_t next_chunk = 0;
+        size_t document_count = 0;
+        try
+        {
+            while (next_chunk < chunks.size() || !parsed_chunks.empty())
+            {
+                for (; next_chunk < chunks.size() && parsed_chunks.size() < parsed_ahead; ++next_chunk)
+                {
+                    parsed_chunks.push_back(thread_pool.Async([chunk = chunks[next_chunk]] { return ParseCorpusRecords(chunk); }));
+                }
+                std::future<std::vector<CorpusRecord>> parsed_chunk = std::move(parsed_chunks.front());
+                parsed_chunks.pop_front();
+                const std::vector<CorpusRecord> records = parsed_chunk.get();
+                for (const CorpusRecord& record : records)
+                {
+                    search_server.AddDocument(record.id, record.text, record.status, record.ratings);
+                }
+                document_count += records.size();
+            }
+        }
+        catch (...)
+        {
+            // The tasks read the corpus, which the caller may release once the exception leaves
+            for (const auto& parsed_chunk : parsed_chunks)
+            {
+                parsed_chunk.wait();
+            }
+            throw;
+        }
+        return document_count;
+    }
+}
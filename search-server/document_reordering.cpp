@@ -0,0 +1,132 @@
+#include "document_reordering.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace
+{
+    // Swap rounds per split; the gains fade after a few
+    constexpr size_t ITERATION_COUNT = 12;
+    // Parts this small are left as they are
+    constexpr size_t MIN_PART_SIZE = 16;
+
+    class Bisection
+    {
+    public:
+        Bisection(const std::vector<std::vector<uint32_t>>& document_terms, size_t term_count)
+            : document_terms_(document_terms)
+            , left_degrees_(term_count, 0)
+            , right_degrees_(term_count, 0)
+            , move_left_gains_(term_count, 0.0)
+            , move_right_gains_(term_count, 0.0)
+        {
+        }
+
+        void Split(std::vector<uint32_t>::iterator begin, std::vector<uint32_t>::iterator end)
+        {
+            const size_t size = static_cast<size_t>(end - begin);
+            if (size < 2 * MIN_PART_SIZE)
+            {
+                return;
+            }
+            const auto middle = begin + size / 2;
+            for (size_t iteration = 0; iteration < ITERATION_COUNT; ++iteration)
+            {
+                if (!SwapRound(begin, middle, end))
+                {
+                    break;
+                }
+            }
+            Split(begin, middle);
+            Split(middle, end);
+        }
+
+    private:
+        const std::vector<std::vector<uint32_t>>& document_terms_;
+        // Scratch indexed by term, cleared for the touched terms after every round
+        std::vector<uint32_t> left_degrees_;
+        std::vector<uint32_t> right_degrees_;
+        std::vector<double> move_left_gains_;
+        std::vector<double> move_right_gains_;
+        std::vector<uint32_t> touched_terms_;
+        std::vector<std::pair<double, uint32_t>> left_gains_;
+        std::vector<std::pair<double, uint32_t>> right_gains_;
+
+        // Estimated bits of the gaps of a term with `degree` documents in a part of `size`
+        static double GetCost(uint32_t degree, size_t size)
+        {
+            return degree * std::log2(static_cast<double>(size) / (degree + 1));
+        }
+
+        // Returns false if no swap lowers the cost
+        bool SwapRound(std::vector<uint32_t>::iterator begin, std::vector<uint32_t>::iterator middle,
+            std::vector<uint32_t>::iterator end)
+        {
+            const size_t left_size = static_cast<size_t>(middle - begin);
+            const size_t right_size = static_cast<size_t>(end - middle);
+            for (auto it = begin; it != end; ++it)
+            {
+                std::vector<uint32_t>& degrees = it < middle ? left_degrees_ : right_degrees_;
+                for (const uint32_t term : document_terms_[*it])
+                {
+                    if (left_degrees_[term] == 0 && right_degrees_[term] == 0)
+                    {
+                        touched_terms_.push_back(term);
+                    }
+                    ++degrees[term];
+                }
+            }
+            for (const uint32_t term : touched_terms_)
+            {
+                const uint32_t left = left_degrees_[term];
+                const uint32_t right = right_degrees_[term];
+                const double cost = GetCost(left, left_size) + GetCost(right, right_size);
+                move_right_gains_[term] = left > 0 ? cost - GetCost(left - 1, left_size) - GetCost(right + 1, right_size) : 0.0;
+                move_left_gains_[term] = right > 0 ? cost - GetCost(left + 1, left_size) - GetCost(right - 1, right_size) : 0.0;
+            }
+
+            left_gains_.clear();
+            right_gains_.clear();
+            for (auto it = begin; it != end; ++it)
+            {
+                const bool is_left = it < middle;
+                const std::vector<double>& term_gains = is_left ? move_right_gains_ : move_left_gains_;
+                double gain = 0.0;
+                for (const uint32_t term : document_terms_[*it])
+                {
+                    gain += term_gains[term];
+                }
+                (is_left ? left_gains_ : right_gains_).emplace_back(gain, static_cast<uint32_t>(it - begin));
+            }
+            for (const uint32_t term : touched_terms_)
+            {
+                left_degrees_[term] = 0;
+                right_degrees_[term] = 0;
+            }
+            touched_terms_.clear();
+
+            // Pairs are swapped while moving both ways still pays off
+            std::sort(left_gains_.begin(), left_gains_.end(), std::greater<>());
+            std::sort(right_gains_.begin(), right_gains_.end(), std::greater<>());
+            bool swapped = false;
+            for (size_t i = 0; i < std::min(left_gains_.size(), right_gains_.size()); ++i)
+            {
+                if (left_gains_[i].first + right_gains_[i].first <= 0.0)
+                {
+                    break;
+                }
+                std::iter_swap(begin + left_gains_[i].second, begin + right_gains_[i].second);
+                swapped = true;
+            }
+            return swapped;
+        }
+    };
+}
+
+std::vector<uint32_t> ComputeLocalityOrder(const std::vector<std::vector<uint32_t>>& document_terms, size_t term_count)
+{
+    std::vector<uint32_t> order(document_terms.size());
+    std::iota(order.begin(), order.end(), 0);
+    Bisection(document_terms, term_count).Split(order.begin(), order.end());
+    return order;
+}
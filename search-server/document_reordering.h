@@ -0,0 +1,12 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Order of documents that puts documents sharing terms next to each other, by recursive graph bisection
+// (Dhulipala et al., "Compressing Graphs and Indexes with Recursive Graph Bisection"). Every part is split
+// in halves, and the documents whose moves to the other half shorten the estimated id gaps the most are swapped.
+// Posting lists then have smaller gaps, and a query reads fewer distinct regions of the per-document arrays.
+// document_terms[i]: distinct term ids of document i, each below term_count.
+// Returns the documents in the new order; O(postings * log(documents)).
+std::vector<uint32_t> ComputeLocalityOrder(const std::vector<std::vector<uint32_t>>& document_terms, size_t term_count);
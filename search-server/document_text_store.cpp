@@ -0,0 +1,284 @@
+#include "document_text_store.h"
+#include "block_compression.h"
+#include "memory_usage.h"
+#include <algorithm>
+#include <cerrno>
+#include <filesystem>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <stdlib.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // Creates a file that did not exist before, so that no other file is ever truncated
+    std::FILE* CreateUniqueFile(const std::string& directory, std::string& path)
+    {
+        using namespace std::string_literals;
+        const std::filesystem::path base = (directory.empty() ? std::filesystem::temp_directory_path() : std::filesystem::path(directory))
+            / "document_texts."s;
+#ifdef _WIN32
+        for (unsigned attempt = 0; attempt < 1000; ++attempt)
+        {
+            path = base.string() + std::to_string(GetCurrentProcessId()) + "."s + std::to_string(attempt);
+            // "x" opens with O_EXCL: an existing file is refused, not truncated
+            if (std::FILE* file = std::fopen(path.c_str(), "wbx"))
+            {
+                return file;
+            }
+            if (errno != EEXIST)
+            {
+                break;
+            }
+        }
+#else
+        path = base.string() + "XXXXXX"s;
+        // mkstemp opens with O_CREAT | O_EXCL
+        const int descriptor = mkstemp(path.data());
+        if (descriptor != -1)
+        {
+            if (std::FILE* file = fdopen(descriptor, "wb"))
+            {
+                return file;
+            }
+            close(descriptor);
+            std::remove(path.c_str());
+        }
+#endif
+        throw std::runtime_error("Can't create a file in "s + base.parent_path().string());
+    }
+}
+
+DocumentTextStore::DocumentTextStore(TextRetention retention, const std::string& file_directory)
+    : retention_(retention)
+{
+    if (retention_ == TextRetention::MAPPED_FILE)
+    {
+        file_ = CreateUniqueFile(file_directory, file_path_);
+    }
+}
+
+DocumentTextStore::~DocumentTextStore()
+{
+    if (file_ != nullptr)
+    {
+        std::fclose(file_);
+        std::remove(file_path_.c_str());
+    }
+}
+
+TextRetention DocumentTextStore::GetRetention() const
+{
+    return retention_;
+}
+
+const std::string& DocumentTextStore::GetFilePath() const
+{
+    return file_path_;
+}
+
+void DocumentTextStore::Add(int document_id, std::string_view text)
+{
+    using namespace std::string_literals;
+    if (retention_ == TextRetention::NONE)
+    {
+        return;
+    }
+    // A replaced text counts as removed
+    Remove(document_id);
+    Location location{ 0, static_cast<uint32_t>(text.size()), 0 };
+    if (retention_ == TextRetention::MAPPED_FILE)
+    {
+        if (std::fwrite(text.data(), 1, text.size(), file_) != text.size())
+        {
+            throw std::runtime_error("Can't write file "s + file_path_);
+        }
+        location.offset = file_size_;
+        file_size_ += text.size();
+    }
+    else
+    {
+        if (!open_block_.empty() && open_block_.size() + text.size() > BLOCK_SIZE)
+        {
+            SealOpenBlock();
+        }
+        if (open_block_.empty())
+        {
+            open_block_.reserve(BLOCK_SIZE);
+        }
+        location.block = static_cast<uint32_t>(blocks_.size());
+        location.offset = open_block_.size();
+        open_block_ += text;
+    }
+    locations_.emplace(document_id, location);
+    live_bytes_ += text.size();
+}
+
+void DocumentTextStore::Remove(int document_id)
+{
+    const auto it = locations_.find(document_id);
+    if (it == locations_.end())
+    {
+        return;
+    }
+    live_bytes_ -= it->second.size;
+    removed_bytes_ += it->second.size;
+    locations_.erase(it);
+    if (retention_ != TextRetention::MAPPED_FILE && removed_bytes_ > live_bytes_ && removed_bytes_ >= BLOCK_SIZE)
+    {
+        Compact();
+    }
+}
+
+std::string DocumentTextStore::Get(int document_id) const
+{
+    using namespace std::string_literals;
+    if (retention_ == TextRetention::NONE)
+    {
+        throw std::logic_error("Document texts are not retained"s);
+    }
+    const auto it = locations_.find(document_id);
+    if (it == locations_.end())
+    {
+        throw std::out_of_range("Non-existent document id"s);
+    }
+    return retention_ == TextRetention::MAPPED_FILE ? ReadFromFile(it->second) : ReadFromBlocks(it->second);
+}
+
+size_t DocumentTextStore::GetMemoryBytes() const
+{
+    // A hash node holds the key, the value and a link; the bucket array holds a pointer per bucket
+    size_t bytes = locations_.size() * GetHeapBlockBytes(sizeof(void*) + sizeof(std::pair<const int, Location>))
+        + GetHeapBlockBytes(locations_.bucket_count() * sizeof(void*))
+        + GetVectorHeapBytes(blocks_) + GetVectorHeapBytes(raw_block_sizes_) + GetStringHeapBytes(open_block_);
+    for (const std::string& block : blocks_)
+    {
+        bytes += GetStringHeapBytes(block);
+    }
+    std::lock_guard lock(cache_mutex_);
+    for (const auto& [block, text] : cache_)
+    {
+        bytes += GetStringHeapBytes(*text);
+    }
+    return bytes;
+}
+
+void DocumentTextStore::SealOpenBlock()
+{
+    if (retention_ == TextRetention::COMPRESSED)
+    {
+        blocks_.push_back(CompressBlock(open_block_));
+        blocks_.back().shrink_to_fit();
+        raw_block_sizes_.push_back(static_cast<uint32_t>(open_block_.size()));
+        open_block_.clear();
+    }
+    else
+    {
+        open_block_.shrink_to_fit();
+        blocks_.push_back(std::move(open_block_));
+        open_block_ = std::string();
+    }
+}
+
+std::string DocumentTextStore::ReadFromBlocks(const Location& location) const
+{
+    if (location.block == blocks_.size())
+    {
+        return open_block_.substr(location.offset, location.size);
+    }
+    if (retention_ == TextRetention::PLAIN)
+    {
+        return blocks_[location.block].substr(location.offset, location.size);
+    }
+    return GetDecompressedBlock(location.block)->substr(location.offset, location.size);
+}
+
+std::string DocumentTextStore::ReadFromFile(const Location& location) const
+{
+    {
+        std::shared_lock lock(mapping_mutex_);
+        if (mapping_ && location.offset + location.size <= mapping_->GetContent().size())
+        {
+            return std::string(mapping_->GetContent().substr(location.offset, location.size));
+        }
+    }
+    std::unique_lock lock(mapping_mutex_);
+    if (!mapping_ || location.offset + location.size > mapping_->GetContent().size())
+    {
+        // The texts written since the last mapping may still be in the buffer of the stream
+        std::fflush(file_);
+        mapping_ = std::make_unique<MappedFile>(file_path_);
+    }
+    return std::string(mapping_->GetContent().substr(location.offset, location.size));
+}
+
+std::shared_ptr<const std::string> DocumentTextStore::GetDecompressedBlock(uint32_t block) const
+{
+    auto find = [this, block]()
+    {
+        const auto it = std::find_if(cache_.begin(), cache_.end(), [block](const CachedBlock& cached) { return cached.first == block; });
+        if (it != cache_.end())
+        {
+            cache_.splice(cache_.begin(), cache_, it);
+        }
+        return it;
+    };
+    {
+        std::lock_guard lock(cache_mutex_);
+        if (const auto it = find(); it != cache_.end())
+        {
+            return it->second;
+        }
+    }
+    // Decompressed without the lock; a reader that needs the same block meanwhile decompresses it too
+    auto decompressed = std::make_shared<const std::string>(DecompressBlock(blocks_[block], raw_block_sizes_[block]));
+    std::lock_guard lock(cache_mutex_);
+    if (find() == cache_.end())
+    {
+        cache_.emplace_front(block, decompressed);
+        if (cache_.size() > CACHED_BLOCK_COUNT)
+        {
+            cache_.pop_back();
+        }
+    }
+    return decompressed;
+}
+
+void DocumentTextStore::Compact()
+{
+    // The live texts take less than the removed ones, so a copy of them fits in the memory about to be freed
+    std::vector<std::pair<Location, int>> entries;
+    entries.reserve(locations_.size());
+    for (const auto& [document_id, location] : locations_)
+    {
+        entries.emplace_back(location, document_id);
+    }
+    // Block by block, each one is decompressed once
+    std::sort(entries.begin(), entries.end(), [](const auto& lhs, const auto& rhs)
+    {
+        return std::pair{ lhs.first.block, lhs.first.offset } < std::pair{ rhs.first.block, rhs.first.offset };
+    });
+    std::vector<std::pair<int, std::string>> texts;
+    texts.reserve(entries.size());
+    for (const auto& [location, document_id] : entries)
+    {
+        texts.emplace_back(document_id, ReadFromBlocks(location));
+    }
+
+    locations_.clear();
+    blocks_.clear();
+    blocks_.shrink_to_fit();
+    raw_block_sizes_.clear();
+    open_block_ = std::string();
+    cache_.clear();
+    live_bytes_ = 0;
+    removed_bytes_ = 0;
+    for (const auto& [document_id, text] : texts)
+    {
+        Add(document_id, text);
+    }
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include "mapped_file.h"
+#include <cstdint>
+#include <cstdio>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+enum class TextRetention
+{
+    // Texts are dropped once the document is indexed
+    NONE,
+    // Plain texts in memory
+    PLAIN,
+    // Blocks of texts compressed with CompressBlock; the blocks read last are kept decompressed
+    COMPRESSED,
+    // Texts are appended to a file and read through a memory mapping of it, only their locations stay in memory
+    MAPPED_FILE,
+};
+
+// Texts of the documents of a SearchServer, appended one after another to blocks of about BLOCK_SIZE bytes.
+// Removal forgets the location of the text; in memory the removed texts are dropped by a compaction once they
+// take more space than the live ones, the file only grows.
+// Adding and removing require exclusive access, Get may run concurrently with itself.
+class DocumentTextStore
+{
+public:
+    static constexpr size_t BLOCK_SIZE = size_t{ 16 } << 10;
+    static constexpr size_t CACHED_BLOCK_COUNT = 16;
+
+    // file_directory: where MAPPED_FILE creates a file with a new unique name, deleted with the store;
+    // the temporary directory of the system when empty
+    DocumentTextStore(TextRetention retention, const std::string& file_directory);
+
+    DocumentTextStore(const DocumentTextStore&) = delete;
+    DocumentTextStore& operator=(const DocumentTextStore&) = delete;
+
+    ~DocumentTextStore();
+
+    TextRetention GetRetention() const;
+
+    // Empty unless the retention is MAPPED_FILE
+    const std::string& GetFilePath() const;
+
+    // Replaces the text of a document added before
+    void Add(int document_id, std::string_view text);
+
+    // Does nothing if there is no such document
+    void Remove(int document_id);
+
+    // out_of_range if there is no such document, logic_error if texts are not retained
+    std::string Get(int document_id) const;
+
+    // Memory of the texts, of their locations and of the block cache; the mapped file is not counted
+    size_t GetMemoryBytes() const;
+
+private:
+    struct Location
+    {
+        // Offset in the block, in the file for MAPPED_FILE
+        uint64_t offset;
+        uint32_t size;
+        uint32_t block;
+    };
+
+    using CachedBlock = std::pair<uint32_t, std::shared_ptr<const std::string>>;
+
+    const TextRetention retention_;
+    std::string file_path_;
+    std::unordered_map<int, Location> locations_;
+    size_t live_bytes_ = 0;
+    size_t removed_bytes_ = 0;
+    // PLAIN and COMPRESSED: full blocks, and the block being filled, which is never compressed
+    std::vector<std::string> blocks_;
+    std::vector<uint32_t> raw_block_sizes_;
+    std::string open_block_;
+    // COMPRESSED: decompressed blocks, the last read first
+    mutable std::mutex cache_mutex_;
+    mutable std::list<CachedBlock> cache_;
+    // MAPPED_FILE: the mapping covers the file as it was at the last read past its end
+    std::FILE* file_ = nullptr;
+    uint64_t file_size_ = 0;
+    mutable std::shared_mutex mapping_mutex_;
+    mutable std::unique_ptr<MappedFile> mapping_;
+
+    void SealOpenBlock();
+
+    std::string ReadFromBlocks(const Location& location) const;
+
+    std::string ReadFromFile(const Location& location) const;
+
+    // Shared with the readers that hold it, so that eviction never frees a block in use
+    std::shared_ptr<const std::string> GetDecompressedBlock(uint32_t block) const;
+
+    // Rewrites the live texts into new blocks
+    void Compact();
+};
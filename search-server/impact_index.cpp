@@ -0,0 +1,68 @@
+#include "impact_index.h"
+#include "memory_usage.h"
+#include <algorithm>
+
+ImpactList::ImpactList(std::string_view word, const PostingList& postings)
+    : word_(word)
+{
+    std::vector<std::pair<double, int>> impacts;
+    impacts.reserve(postings.size());
+    postings.ForEach([&impacts](int document_id, double term_freq) { impacts.emplace_back(term_freq, document_id); });
+    // Ties keep the order of ids
+    std::stable_sort(impacts.begin(), impacts.end(),
+        [](const std::pair<double, int>& lhs, const std::pair<double, int>& rhs) { return lhs.first > rhs.first; });
+    document_ids_.reserve(impacts.size());
+    term_freqs_.reserve(impacts.size());
+    for (const auto& [term_freq, document_id] : impacts)
+    {
+        document_ids_.push_back(document_id);
+        term_freqs_.push_back(term_freq);
+    }
+}
+
+std::string_view ImpactList::GetWord() const
+{
+    return word_;
+}
+
+size_t ImpactList::GetBlockCount() const
+{
+    return (document_ids_.size() + BLOCK_SIZE - 1) / BLOCK_SIZE;
+}
+
+size_t ImpactList::GetBlockSize(size_t block_index) const
+{
+    return std::min(BLOCK_SIZE, document_ids_.size() - block_index * BLOCK_SIZE);
+}
+
+double ImpactList::GetBlockBound(size_t block_index) const
+{
+    return term_freqs_[block_index * BLOCK_SIZE];
+}
+
+size_t ImpactList::GetMemoryBytes() const
+{
+    return GetVectorHeapBytes(document_ids_) + GetVectorHeapBytes(term_freqs_);
+}
+
+void ImpactIndex::AddTerm(std::string_view word, const PostingList& postings)
+{
+    const auto [it, is_new] = lists_.try_emplace(&postings, word, postings);
+    if (is_new)
+    {
+        list_bytes_ += it->second.GetMemoryBytes();
+    }
+}
+
+const ImpactList* ImpactIndex::Find(const PostingList& postings) const
+{
+    const auto it = lists_.find(&postings);
+    return it == lists_.end() ? nullptr : &it->second;
+}
+
+size_t ImpactIndex::GetMemoryBytes() const
+{
+    // A hash node holds the key, the value and a link; the bucket array holds a pointer per bucket
+    return list_bytes_ + lists_.size() * GetHeapBlockBytes(sizeof(void*) + sizeof(std::pair<const PostingList* const, ImpactList>))
+        + GetHeapBlockBytes(lists_.bucket_count() * sizeof(void*));
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include "posting_list.h"
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Postings of one word by descending term frequency, so the postings that add the most to a score come first.
+// They are split into blocks of BLOCK_SIZE; the first term frequency of a block bounds all the others in it.
+class ImpactList
+{
+public:
+    static constexpr size_t BLOCK_SIZE = PostingList::BLOCK_SIZE;
+
+    ImpactList(std::string_view word, const PostingList& postings);
+
+    std::string_view GetWord() const;
+
+    size_t GetBlockCount() const;
+
+    size_t GetBlockSize(size_t block_index) const;
+
+    // Largest term frequency in the block
+    double GetBlockBound(size_t block_index) const;
+
+    // Calls callback(document_id, term_freq) for every posting of the block
+    template <typename Callback>
+    void ForEachInBlock(size_t block_index, Callback callback) const;
+
+    size_t GetMemoryBytes() const;
+
+private:
+    std::string_view word_;
+    std::vector<int> document_ids_;
+    std::vector<double> term_freqs_;
+};
+
+// Impact-ordered copy of the posting lists of an index, for searches that stop
+// as soon as the best documents are known. Built once for an index that does not change.
+class ImpactIndex
+{
+public:
+    // The word must outlive the index, the postings must stay at their address
+    void AddTerm(std::string_view word, const PostingList& postings);
+
+    // nullptr if the postings were not added
+    const ImpactList* Find(const PostingList& postings) const;
+
+    // Heap memory of the lists and the table over them
+    size_t GetMemoryBytes() const;
+
+private:
+    // Keyed by the address of the source list: queries know their posting lists rather than words
+    std::unordered_map<const PostingList*, ImpactList> lists_;
+    size_t list_bytes_ = 0;
+};
+
+template <typename Callback>
+void ImpactList::ForEachInBlock(size_t block_index, Callback callback) const
+{
+    const size_t begin = block_index * BLOCK_SIZE;
+    for (size_t i = begin; i < begin + GetBlockSize(block_index); ++i)
+    {
+        callback(document_ids_[i], term_freqs_[i]);
+    }
+}
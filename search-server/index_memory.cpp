@@ -0,0 +1,114 @@
+#include "index_memory.h"
+#include <atomic>
+#include <new>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace
+{
+    // Memory of the pools and the arena straight from the system, counted. Huge pages come in whole 2 MiB pages
+    // from mmap: explicit huge pages when the system has them reserved, otherwise regular pages with a
+    // transparent huge page hint
+    class SystemResource : public std::pmr::memory_resource
+    {
+    public:
+        explicit SystemResource(bool use_huge_pages)
+            : use_huge_pages_(use_huge_pages)
+        {
+        }
+
+        size_t GetBytes() const
+        {
+            return bytes_;
+        }
+
+    private:
+        static constexpr size_t HUGE_PAGE_SIZE = size_t{ 2 } << 20;
+
+        const bool use_huge_pages_;
+        std::atomic<size_t> bytes_ = 0;
+
+        static size_t RoundUp(size_t bytes)
+        {
+            return (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+        }
+
+        void* do_allocate(size_t bytes, size_t alignment) override
+        {
+#ifdef __linux__
+            if (use_huge_pages_)
+            {
+                const size_t length = RoundUp(bytes);
+                void* memory = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+                if (memory == MAP_FAILED)
+                {
+                    memory = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                    if (memory == MAP_FAILED)
+                    {
+                        throw std::bad_alloc();
+                    }
+                    madvise(memory, length, MADV_HUGEPAGE);
+                }
+                bytes_ += length;
+                return memory;
+            }
+#endif
+            void* memory = std::pmr::new_delete_resource()->allocate(bytes, alignment);
+            bytes_ += bytes;
+            return memory;
+        }
+
+        void do_deallocate(void* memory, size_t bytes, size_t alignment) override
+        {
+#ifdef __linux__
+            if (use_huge_pages_)
+            {
+                munmap(memory, RoundUp(bytes));
+                bytes_ -= RoundUp(bytes);
+                return;
+            }
+#endif
+            std::pmr::new_delete_resource()->deallocate(memory, bytes, alignment);
+            bytes_ -= bytes;
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+        {
+            return this == &other;
+        }
+    };
+}
+
+IndexMemory::IndexMemory(IndexAllocation allocation, bool use_huge_pages)
+{
+    if (allocation == IndexAllocation::POOL)
+    {
+        upstream_ = std::make_unique<SystemResource>(false);
+        resource_ = std::make_unique<std::pmr::synchronized_pool_resource>(upstream_.get());
+    }
+    else if (allocation == IndexAllocation::ARENA)
+    {
+        upstream_ = std::make_unique<SystemResource>(use_huge_pages);
+        const size_t initial_size = use_huge_pages ? size_t{ 2 } << 20 : size_t{ 64 } << 10;
+        arena_ = std::make_unique<std::pmr::monotonic_buffer_resource>(initial_size, upstream_.get());
+        // Posting blocks are re-encoded on every insertion; the pool reuses the memory of the old ones
+        resource_ = std::make_unique<std::pmr::synchronized_pool_resource>(arena_.get());
+    }
+}
+
+std::pmr::memory_resource* IndexMemory::GetResource() const
+{
+    return resource_ ? resource_.get() : std::pmr::new_delete_resource();
+}
+
+bool IndexMemory::IsReleasedAtOnce() const
+{
+    return resource_ != nullptr;
+}
+
+size_t IndexMemory::GetReservedBytes() const
+{
+    return upstream_ ? static_cast<const SystemResource&>(*upstream_).GetBytes() : 0;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <memory>
+#include <memory_resource>
+
+enum class IndexAllocation
+{
+    // Every node comes from the global heap and is freed on its own
+    GLOBAL_HEAP,
+    // Thread-safe pools of same-sized blocks: cheap allocation and reuse for an index that keeps changing
+    POOL,
+    // Pools carved from a monotonic arena that never returns memory before the index is destroyed;
+    // for indexes built in bulk and then only searched
+    ARENA,
+};
+
+// Memory resource of the index containers of one SearchServer.
+// Pools and arenas return all their memory to the system when they are destroyed,
+// so the objects in them need not be destroyed one by one.
+class IndexMemory
+{
+public:
+    // Huge pages back the arena only: pools would round each of their small chunks up to 2 MiB
+    IndexMemory(IndexAllocation allocation, bool use_huge_pages);
+
+    IndexMemory(const IndexMemory&) = delete;
+    IndexMemory& operator=(const IndexMemory&) = delete;
+
+    std::pmr::memory_resource* GetResource() const;
+
+    bool IsReleasedAtOnce() const;
+
+    // Memory the pools or the arena hold from the system, free blocks included; 0 for the global heap.
+    // An arena only grows until it is destroyed
+    size_t GetReservedBytes() const;
+
+private:
+    // Declared in the order they are built on each other; the system memory of pools and arenas
+    std::unique_ptr<std::pmr::memory_resource> upstream_;
+    std::unique_ptr<std::pmr::memory_resource> arena_;
+    // nullptr for the global heap
+    std::unique_ptr<std::pmr::memory_resource> resource_;
+};
@@ -0,0 +1,241 @@
+#include "index_segment.h"
+#include "document_reordering.h"
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+
+IndexSegment::IndexSegment(size_t capacity)
+    : tombstones_((capacity + 63) / 64)
+{
+    document_ids_.reserve(capacity);
+    statuses_.reserve(capacity);
+    ratings_.reserve(capacity);
+    document_lengths_.reserve(capacity);
+    forward_index_.reserve(capacity);
+    ordinals_by_id_.reserve(capacity);
+}
+
+uint32_t IndexSegment::AddDocument(int document_id, DocumentStatus status, int rating,
+    const std::vector<std::pair<std::string_view, uint32_t>>& word_counts, uint32_t document_length)
+{
+    const uint32_t ordinal = AppendDocument(document_id, status, rating, word_counts, document_length);
+    const auto position = std::lower_bound(ordinals_by_id_.begin(), ordinals_by_id_.end(), document_id,
+        [this](uint32_t lhs, int id) { return document_ids_[lhs] < id; });
+    ordinals_by_id_.insert(position, ordinal);
+    return ordinal;
+}
+
+uint32_t IndexSegment::AppendDocument(int document_id, DocumentStatus status, int rating,
+    const std::vector<std::pair<std::string_view, uint32_t>>& word_counts, uint32_t document_length)
+{
+    using namespace std::string_literals;
+    if (is_sealed_)
+    {
+        throw std::logic_error("Segment is sealed"s);
+    }
+    if (document_ids_.size() == GetCapacity())
+    {
+        throw std::length_error("Segment is full"s);
+    }
+    const uint32_t ordinal = static_cast<uint32_t>(document_ids_.size());
+    document_ids_.push_back(document_id);
+    statuses_.push_back(status);
+    ratings_.push_back(rating);
+    document_lengths_.push_back(document_length);
+
+    std::vector<ForwardEntry>& forward = forward_index_.emplace_back();
+    forward.reserve(word_counts.size());
+    for (const auto& [word, word_count] : word_counts)
+    {
+        auto it = terms_.find(word);
+        if (it == terms_.end())
+        {
+            it = terms_.try_emplace(std::string(word)).first;
+        }
+        // Ordinals only grow, so every insertion is an append to the last block
+        it->second.postings.Insert(static_cast<int>(ordinal), word_count, document_length);
+        it->second.live_document_freq.fetch_add(1, std::memory_order_relaxed);
+        forward.push_back({ &*it, word_count });
+    }
+    live_document_count_.fetch_add(1, std::memory_order_relaxed);
+    return ordinal;
+}
+
+uint32_t IndexSegment::FindOrdinal(int document_id) const
+{
+    const auto position = std::lower_bound(ordinals_by_id_.begin(), ordinals_by_id_.end(), document_id,
+        [this](uint32_t lhs, int id) { return document_ids_[lhs] < id; });
+    // An id may repeat when a document was deleted and added again
+    for (auto it = position; it != ordinals_by_id_.end() && document_ids_[*it] == document_id; ++it)
+    {
+        if (!IsDeleted(*it))
+        {
+            return *it;
+        }
+    }
+    return NO_ORDINAL;
+}
+
+bool IndexSegment::Delete(uint32_t ordinal)
+{
+    const uint64_t bit = uint64_t{ 1 } << (ordinal % 64);
+    if (tombstones_[ordinal / 64].fetch_or(bit, std::memory_order_relaxed) & bit)
+    {
+        return false;
+    }
+    for (const ForwardEntry& entry : forward_index_[ordinal])
+    {
+        entry.term->second.live_document_freq.fetch_sub(1, std::memory_order_relaxed);
+    }
+    live_document_count_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool IndexSegment::IsDeleted(uint32_t ordinal) const
+{
+    return (tombstones_[ordinal / 64].load(std::memory_order_relaxed) >> (ordinal % 64)) & 1;
+}
+
+int IndexSegment::GetDocumentId(uint32_t ordinal) const
+{
+    return document_ids_[ordinal];
+}
+
+DocumentStatus IndexSegment::GetStatus(uint32_t ordinal) const
+{
+    return statuses_[ordinal];
+}
+
+int IndexSegment::GetRating(uint32_t ordinal) const
+{
+    return ratings_[ordinal];
+}
+
+size_t IndexSegment::GetCapacity() const
+{
+    return tombstones_.size() * 64;
+}
+
+size_t IndexSegment::GetDocumentCount() const
+{
+    return document_ids_.size();
+}
+
+size_t IndexSegment::GetLiveDocumentCount() const
+{
+    return live_document_count_.load(std::memory_order_relaxed);
+}
+
+const PostingList* IndexSegment::FindPostings(std::string_view word) const
+{
+    const TermEntry* term = FindTerm(word);
+    return term == nullptr ? nullptr : &term->second.postings;
+}
+
+size_t IndexSegment::GetLiveDocumentFreq(std::string_view word) const
+{
+    const TermEntry* term = FindTerm(word);
+    return term == nullptr ? 0 : term->second.live_document_freq.load(std::memory_order_relaxed);
+}
+
+void IndexSegment::Seal()
+{
+    filter_ = TermFilter(terms_.size());
+    for (const auto& [word, term] : terms_)
+    {
+        filter_.Add(word);
+    }
+    is_sealed_ = true;
+}
+
+TermFilter::Stats IndexSegment::GetFilterStats() const
+{
+    return filter_.GetStats();
+}
+
+size_t IndexSegment::GetPostingBytes() const
+{
+    size_t bytes = 0;
+    for (const auto& [word, term] : terms_)
+    {
+        bytes += term.postings.GetEncodedBytes();
+    }
+    return bytes;
+}
+
+std::shared_ptr<IndexSegment> IndexSegment::Merge(const std::vector<std::shared_ptr<IndexSegment>>& segments,
+    std::vector<std::vector<uint32_t>>& new_ordinals, DocumentOrder order)
+{
+    // (document id, source segment, source ordinal) of every live document
+    std::vector<std::tuple<int, size_t, uint32_t>> live_documents;
+    new_ordinals.assign(segments.size(), {});
+    for (size_t i = 0; i < segments.size(); ++i)
+    {
+        new_ordinals[i].assign(segments[i]->GetDocumentCount(), NO_ORDINAL);
+        for (uint32_t ordinal = 0; ordinal < segments[i]->GetDocumentCount(); ++ordinal)
+        {
+            if (!segments[i]->IsDeleted(ordinal))
+            {
+                live_documents.emplace_back(segments[i]->GetDocumentId(ordinal), i, ordinal);
+            }
+        }
+    }
+    std::sort(live_documents.begin(), live_documents.end());
+    if (order == DocumentOrder::LOCALITY)
+    {
+        // Words of the sources numbered densely for the bisection
+        std::unordered_map<std::string_view, uint32_t> term_ids;
+        std::vector<std::vector<uint32_t>> document_terms(live_documents.size());
+        for (size_t i = 0; i < live_documents.size(); ++i)
+        {
+            const auto& [document_id, source, ordinal] = live_documents[i];
+            for (const ForwardEntry& entry : segments[source]->forward_index_[ordinal])
+            {
+                const auto [term_id, is_new] = term_ids.try_emplace(entry.term->first, static_cast<uint32_t>(term_ids.size()));
+                document_terms[i].push_back(term_id->second);
+            }
+        }
+        std::vector<std::tuple<int, size_t, uint32_t>> ordered_documents;
+        ordered_documents.reserve(live_documents.size());
+        for (const uint32_t i : ComputeLocalityOrder(document_terms, term_ids.size()))
+        {
+            ordered_documents.push_back(live_documents[i]);
+        }
+        live_documents = std::move(ordered_documents);
+    }
+
+    auto merged = std::make_shared<IndexSegment>(live_documents.size());
+    std::vector<std::pair<std::string_view, uint32_t>> word_counts;
+    for (const auto& [document_id, source, ordinal] : live_documents)
+    {
+        const IndexSegment& segment = *segments[source];
+        word_counts.clear();
+        for (const ForwardEntry& entry : segment.forward_index_[ordinal])
+        {
+            word_counts.emplace_back(entry.term->first, entry.word_count);
+        }
+        new_ordinals[source][ordinal] = merged->AppendDocument(document_id, segment.statuses_[ordinal], segment.ratings_[ordinal],
+            word_counts, segment.document_lengths_[ordinal]);
+    }
+    // Ids of live documents are unique, one sort replaces the insertions
+    merged->ordinals_by_id_.resize(live_documents.size());
+    std::iota(merged->ordinals_by_id_.begin(), merged->ordinals_by_id_.end(), 0);
+    std::sort(merged->ordinals_by_id_.begin(), merged->ordinals_by_id_.end(),
+        [&merged](uint32_t lhs, uint32_t rhs) { return merged->document_ids_[lhs] < merged->document_ids_[rhs]; });
+    merged->Seal();
+    return merged;
+}
+
+// private methods
+const IndexSegment::TermEntry* IndexSegment::FindTerm(std::string_view word) const
+{
+    if (is_sealed_ && !filter_.MayContain(word))
+    {
+        return nullptr;
+    }
+    const auto it = terms_.find(word);
+    return it == terms_.end() ? nullptr : &*it;
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include "document.h"
+#include "posting_list.h"
+#include "term_filter.h"
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Order of the documents of a merged segment
+enum class DocumentOrder
+{
+    BY_ID,
+    // Documents with common words together: smaller posting gaps and denser access to the per-document arrays
+    LOCALITY,
+};
+
+// One segment of a SegmentedIndex. Documents get dense ordinals in the order they are added,
+// postings refer to ordinals, so a document is found by index rather than by a tree search.
+// A segment only grows while it is the active one; sealed segments are immutable except for
+// deletion, which sets a tombstone bit and keeps the live document frequencies exact.
+// A sealed segment checks query words against a Bloom filter before its term tree.
+// Deletion and the const methods may run concurrently; adding requires exclusive access.
+class IndexSegment
+{
+public:
+    static constexpr uint32_t NO_ORDINAL = static_cast<uint32_t>(-1);
+
+    // Holds at most `capacity` documents
+    explicit IndexSegment(size_t capacity);
+
+    // word_counts: distinct words of the document with their occurrences
+    uint32_t AddDocument(int document_id, DocumentStatus status, int rating,
+        const std::vector<std::pair<std::string_view, uint32_t>>& word_counts, uint32_t document_length);
+
+    // Ordinal of the live document with the id, NO_ORDINAL if there is none
+    uint32_t FindOrdinal(int document_id) const;
+
+    // Returns false if the document is already deleted
+    bool Delete(uint32_t ordinal);
+
+    bool IsDeleted(uint32_t ordinal) const;
+
+    int GetDocumentId(uint32_t ordinal) const;
+
+    DocumentStatus GetStatus(uint32_t ordinal) const;
+
+    int GetRating(uint32_t ordinal) const;
+
+    size_t GetCapacity() const;
+
+    // Including the deleted documents
+    size_t GetDocumentCount() const;
+
+    size_t GetLiveDocumentCount() const;
+
+    // nullptr if no document of the segment has ever had the word
+    const PostingList* FindPostings(std::string_view word) const;
+
+    // Live documents of the segment that contain the word
+    size_t GetLiveDocumentFreq(std::string_view word) const;
+
+    // Builds the filter of the segment words, lookups of unknown words skip the tree after it.
+    // The segment must not grow any more.
+    void Seal();
+
+    TermFilter::Stats GetFilterStats() const;
+
+    // Encoded size of all the posting lists; O(words)
+    size_t GetPostingBytes() const;
+
+    // Live documents of the sources in one segment.
+    // new_ordinals[i][ordinal] is the ordinal of the document of segments[i] in the result, NO_ORDINAL if it was deleted.
+    static std::shared_ptr<IndexSegment> Merge(const std::vector<std::shared_ptr<IndexSegment>>& segments,
+        std::vector<std::vector<uint32_t>>& new_ordinals, DocumentOrder order = DocumentOrder::BY_ID);
+
+private:
+    struct Term
+    {
+        PostingList postings;
+        std::atomic<uint32_t> live_document_freq = 0;
+    };
+
+    using TermEntry = std::pair<const std::string, Term>;
+
+    struct ForwardEntry
+    {
+        TermEntry* term;
+        uint32_t word_count;
+    };
+
+    std::map<std::string, Term, std::less<>> terms_;
+    std::vector<int> document_ids_;
+    std::vector<DocumentStatus> statuses_;
+    std::vector<int> ratings_;
+    std::vector<uint32_t> document_lengths_;
+    // Forward index, used to keep the live frequencies on deletion and to rebuild postings on merge
+    std::vector<std::vector<ForwardEntry>> forward_index_;
+    // Ordinals in the ascending order of document ids
+    std::vector<uint32_t> ordinals_by_id_;
+    std::vector<std::atomic<uint64_t>> tombstones_;
+    std::atomic<size_t> live_document_count_ = 0;
+    bool is_sealed_ = false;
+    TermFilter filter_;
+
+    // nullptr if the segment has no such word
+    const TermEntry* FindTerm(std::string_view word) const;
+
+    // AddDocument without the update of ordinals_by_id_
+    uint32_t AppendDocument(int document_id, DocumentStatus status, int rating,
+        const std::vector<std::pair<std::string_view, uint32_t>>& word_counts, uint32_t document_length);
+};
@@ -0,0 +1,32 @@
+#include "memory_usage.h"
+
+size_t MemoryUsage::GetTotal() const
+{
+    return stop_words + dictionary + postings + forward_index + document_metadata + document_text + impact_index + index_resource;
+}
+
+MemoryUsage& MemoryUsage::operator+=(const MemoryUsage& other)
+{
+    stop_words += other.stop_words;
+    dictionary += other.dictionary;
+    postings += other.postings;
+    forward_index += other.forward_index;
+    document_metadata += other.document_metadata;
+    document_text += other.document_text;
+    impact_index += other.impact_index;
+    index_resource += other.index_resource;
+    return *this;
+}
+
+MemoryUsage& MemoryUsage::operator-=(const MemoryUsage& other)
+{
+    stop_words -= other.stop_words;
+    dictionary -= other.dictionary;
+    postings -= other.postings;
+    forward_index -= other.forward_index;
+    document_metadata -= other.document_metadata;
+    document_text -= other.document_text;
+    impact_index -= other.impact_index;
+    index_resource -= other.index_resource;
+    return *this;
+}
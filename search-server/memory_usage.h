@@ -0,0 +1,60 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Bytes held by the structures of a SearchServer, node and allocator overhead included
+struct MemoryUsage
+{
+    size_t stop_words = 0;
+    // Word storage, word ids and the term filter
+    size_t dictionary = 0;
+    // Posting lists and the tree over them; with IndexAllocation::GLOBAL_HEAP only
+    size_t postings = 0;
+    // Word frequencies and term ids of every document; with IndexAllocation::GLOBAL_HEAP only
+    size_t forward_index = 0;
+    // Rating and status of every document and the set of ids; with IndexAllocation::GLOBAL_HEAP only
+    size_t document_metadata = 0;
+    size_t document_text = 0;
+    // Impact-ordered copy of the postings, when it is built
+    size_t impact_index = 0;
+    // With IndexAllocation::POOL and ARENA the three structures above share one memory resource and are
+    // counted together here: the memory it holds from the system, free pool blocks and, for an arena,
+    // the memory of removed documents included
+    size_t index_resource = 0;
+
+    size_t GetTotal() const;
+
+    MemoryUsage& operator+=(const MemoryUsage& other);
+
+    MemoryUsage& operator-=(const MemoryUsage& other);
+};
+
+// The estimates below follow the layouts of libstdc++ and glibc malloc on 64-bit platforms
+
+// Memory taken by an allocation of `bytes`: a chunk has an 8-byte header, is aligned to 16 bytes and takes at least 32
+inline size_t GetHeapBlockBytes(size_t bytes)
+{
+    return bytes == 0 ? 0 : std::max<size_t>(32, (bytes + 8 + 15) / 16 * 16);
+}
+
+// Node of std::map and std::set: colour and three links before the value
+template <typename Value>
+size_t GetTreeNodeBytes()
+{
+    return GetHeapBlockBytes(4 * sizeof(void*) + sizeof(Value));
+}
+
+template <typename T, typename Allocator>
+size_t GetVectorHeapBytes(const std::vector<T, Allocator>& values)
+{
+    return GetHeapBlockBytes(values.capacity() * sizeof(T));
+}
+
+// Short strings live inside the object and take no heap
+template <typename Allocator>
+size_t GetStringHeapBytes(const std::basic_string<char, std::char_traits<char>, Allocator>& text)
+{
+    return text.capacity() > 15 ? GetHeapBlockBytes(text.capacity() + 1) : 0;
+}
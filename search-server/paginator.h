@@ -1,6 +1,12 @@
 #pragma once
+#include "document.h"
+#include "search_cursor.h"
 #include <vector>
 #include <algorithm>
+#include <execution>
+#include <iterator>
+#include <optional>
+#include <string_view>
 
 template <typename Iterator>
 class IteratorRange
@@ -83,4 +89,120 @@ template <typename Container>
 auto Paginate(const Container& c, size_t page_size)
 {
     return Paginator(begin(c), end(c), page_size);
-}
\ No newline at end of file
+}
+
+// Pages are pulled from the source one at a time while iterating:
+// fetch_page(last item of the previous page or std::nullopt) returns the next page
+template <typename Item, typename PageFetcher>
+class LazyPaginator
+{
+public:
+    using Page = std::vector<Item>;
+
+    class Iterator
+    {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Page;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Page*;
+        using reference = const Page&;
+
+        Iterator() = default;
+
+        explicit Iterator(LazyPaginator* paginator)
+            : paginator_(paginator)
+            , page_(paginator->fetch_page_(std::nullopt))
+        {
+            if (page_.empty())
+            {
+                paginator_ = nullptr;
+            }
+        }
+
+        reference operator*() const
+        {
+            return page_;
+        }
+
+        pointer operator->() const
+        {
+            return &page_;
+        }
+
+        Iterator& operator++()
+        {
+            // A short page is the last one, no need to ask for more
+            if (page_.size() < paginator_->page_size_)
+            {
+                page_.clear();
+            }
+            else
+            {
+                page_ = paginator_->fetch_page_(std::optional<Item>(page_.back()));
+            }
+            if (page_.empty())
+            {
+                paginator_ = nullptr;
+            }
+            return *this;
+        }
+
+        bool operator==(const Iterator& other) const
+        {
+            return paginator_ == other.paginator_;
+        }
+
+        bool operator!=(const Iterator& other) const
+        {
+            return !(*this == other);
+        }
+
+    private:
+        LazyPaginator* paginator_ = nullptr;
+        Page page_;
+    };
+
+    LazyPaginator(PageFetcher fetch_page, size_t page_size)
+        : fetch_page_(std::move(fetch_page))
+        , page_size_(page_size)
+    {
+    }
+
+    Iterator begin()
+    {
+        return Iterator(this);
+    }
+
+    Iterator end()
+    {
+        return {};
+    }
+
+private:
+    PageFetcher fetch_page_;
+    size_t page_size_;
+};
+
+// Lazily paginated search results: the query is scored when the first page is asked for, the next pages
+// are taken from its SearchCursor; raw_query must outlive the paginator
+template <typename Server, typename DocumentFilter>
+auto PaginateSearch(const Server& search_server, std::string_view raw_query, DocumentFilter document_filter, size_t page_size)
+{
+    auto fetch_page = [&search_server, raw_query, document_filter, page_size, cursor = SearchCursor()](const std::optional<Document>& after) mutable
+    {
+        // Every iteration starts with the first page
+        if (!after)
+        {
+            cursor = search_server.OpenSearchCursor(std::execution::seq, raw_query, document_filter);
+        }
+        return cursor.NextPage(page_size);
+    };
+    return LazyPaginator<Document, decltype(fetch_page)>(std::move(fetch_page), page_size);
+}
+
+template <typename Server>
+auto PaginateSearch(const Server& search_server, std::string_view raw_query, size_t page_size)
+{
+    return PaginateSearch(search_server, raw_query, DocumentStatus::ACTUAL, page_size);
+}
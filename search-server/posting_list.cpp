@@ -0,0 +1,442 @@
+#include "posting_list.h"
+#include "memory_usage.h"
+#include <algorithm>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define POSTING_LIST_SSSE3
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    // Group of four values: tag byte with 2 bits of (byte length - 1) per value, then the value bytes
+    constexpr size_t GROUP_SIZE = 4;
+    constexpr size_t MAX_GROUP_BYTES = 1 + GROUP_SIZE * sizeof(uint32_t);
+    // Three groups (id gaps, word counts, document lengths) per four postings
+    constexpr size_t MAX_BLOCK_BYTES = (PostingList::BLOCK_SIZE / GROUP_SIZE) * 3 * MAX_GROUP_BYTES;
+
+    struct GroupTables
+    {
+        uint8_t shuffles[256][16];
+        uint8_t data_lengths[256];
+    };
+
+    constexpr GroupTables MakeGroupTables()
+    {
+        GroupTables tables{};
+        for (int tag = 0; tag < 256; ++tag)
+        {
+            uint8_t offset = 0;
+            for (int i = 0; i < 4; ++i)
+            {
+                const int length = ((tag >> (2 * i)) & 3) + 1;
+                for (int byte = 0; byte < 4; ++byte)
+                {
+                    // 0x80 makes pshufb write a zero byte
+                    tables.shuffles[tag][4 * i + byte] = byte < length ? static_cast<uint8_t>(offset + byte) : 0x80;
+                }
+                offset += length;
+            }
+            tables.data_lengths[tag] = offset;
+        }
+        return tables;
+    }
+
+    constexpr GroupTables GROUP_TABLES = MakeGroupTables();
+
+    size_t EncodeGroup(const uint32_t* values, size_t count, uint8_t* out)
+    {
+        uint8_t tag = 0;
+        size_t position = 1;
+        for (size_t i = 0; i < GROUP_SIZE; ++i)
+        {
+            const uint32_t value = i < count ? values[i] : 0;
+            const size_t length = value < (1u << 8) ? 1 : value < (1u << 16) ? 2 : value < (1u << 24) ? 3 : 4;
+            tag |= static_cast<uint8_t>((length - 1) << (2 * i));
+            for (size_t byte = 0; byte < length; ++byte)
+            {
+                out[position++] = static_cast<uint8_t>(value >> (8 * byte));
+            }
+        }
+        out[0] = tag;
+        return position;
+    }
+
+    const uint8_t* DecodeGroupScalar(const uint8_t* in, uint32_t* values)
+    {
+        const uint8_t tag = *in++;
+        for (size_t i = 0; i < GROUP_SIZE; ++i)
+        {
+            const size_t length = ((tag >> (2 * i)) & 3) + 1;
+            uint32_t value = 0;
+            for (size_t byte = 0; byte < length; ++byte)
+            {
+                value |= static_cast<uint32_t>(in[byte]) << (8 * byte);
+            }
+            values[i] = value;
+            in += length;
+        }
+        return in;
+    }
+
+    using GroupsDecoder = void (*)(const uint8_t* in, const uint8_t* end, size_t size,
+        uint32_t* gaps, uint32_t* word_counts, uint32_t* document_lengths);
+
+    void DecodeGroupsScalar(const uint8_t* in, const uint8_t* end, size_t size,
+        uint32_t* gaps, uint32_t* word_counts, uint32_t* document_lengths)
+    {
+        for (size_t i = 0; i < size; i += GROUP_SIZE)
+        {
+            in = DecodeGroupScalar(in, gaps + i);
+            in = DecodeGroupScalar(in, word_counts + i);
+            in = DecodeGroupScalar(in, document_lengths + i);
+        }
+    }
+
+#ifdef POSTING_LIST_SSSE3
+    __attribute__((target("ssse3")))
+    inline const uint8_t* DecodeGroupSsse3(const uint8_t* in, uint32_t* values)
+    {
+        const uint8_t tag = *in;
+        const __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 1));
+        const __m128i shuffle = _mm_loadu_si128(reinterpret_cast<const __m128i*>(GROUP_TABLES.shuffles[tag]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(values), _mm_shuffle_epi8(data, shuffle));
+        return in + 1 + GROUP_TABLES.data_lengths[tag];
+    }
+
+    __attribute__((target("ssse3")))
+    void DecodeGroupsSsse3(const uint8_t* in, const uint8_t* end, size_t size,
+        uint32_t* gaps, uint32_t* word_counts, uint32_t* document_lengths)
+    {
+        size_t i = 0;
+        // A 16-byte load may run past the last group, the block tail is decoded by the scalar code
+        for (; i < size && end - in >= static_cast<std::ptrdiff_t>(3 * MAX_GROUP_BYTES); i += GROUP_SIZE)
+        {
+            in = DecodeGroupSsse3(in, gaps + i);
+            in = DecodeGroupSsse3(in, word_counts + i);
+            in = DecodeGroupSsse3(in, document_lengths + i);
+        }
+        if (i < size)
+        {
+            DecodeGroupsScalar(in, end, size - i, gaps + i, word_counts + i, document_lengths + i);
+        }
+    }
+#endif
+
+    GroupsDecoder ChooseGroupsDecoder()
+    {
+#ifdef POSTING_LIST_SSSE3
+        if (__builtin_cpu_supports("ssse3"))
+        {
+            return DecodeGroupsSsse3;
+        }
+#endif
+        return DecodeGroupsScalar;
+    }
+
+    GroupsDecoder GetGroupsDecoder()
+    {
+        static const GroupsDecoder decoder = ChooseGroupsDecoder();
+        return decoder;
+    }
+}
+
+PostingList::PostingList(const allocator_type& allocator)
+    : blocks_(allocator)
+{
+}
+
+PostingList::PostingList(const PostingList& other, const allocator_type& allocator)
+    : blocks_(other.blocks_, allocator)
+    , size_(other.size_)
+    , block_heap_bytes_(other.block_heap_bytes_)
+{
+}
+
+PostingList::PostingList(PostingList&& other, const allocator_type& allocator)
+    : blocks_(std::move(other.blocks_), allocator)
+    , size_(other.size_)
+    , block_heap_bytes_(other.block_heap_bytes_)
+{
+}
+
+void PostingList::Insert(int document_id, uint32_t word_count, uint32_t document_length)
+{
+    if (blocks_.empty())
+    {
+        RawBlock raw;
+        raw.size = 1;
+        raw.document_ids[0] = static_cast<uint32_t>(document_id);
+        raw.word_counts[0] = word_count;
+        raw.document_lengths[0] = document_length;
+        InsertBlock(blocks_.size(), EncodeRaw(raw, 0, 1));
+        size_ = 1;
+        return;
+    }
+
+    const size_t block_index = FindBlock(document_id);
+    // Appending to a full last block starts a new one, so that bulk loading in id order leaves full blocks
+    if (block_index + 1 == blocks_.size() && blocks_.back().size == BLOCK_SIZE && blocks_.back().last_document_id < document_id)
+    {
+        RawBlock raw;
+        raw.size = 1;
+        raw.document_ids[0] = static_cast<uint32_t>(document_id);
+        raw.word_counts[0] = word_count;
+        raw.document_lengths[0] = document_length;
+        InsertBlock(blocks_.size(), EncodeRaw(raw, 0, 1));
+        ++size_;
+        return;
+    }
+
+    RawBlock raw;
+    DecodeRaw(blocks_[block_index], raw);
+    const uint32_t id = static_cast<uint32_t>(document_id);
+    const size_t position = std::lower_bound(raw.document_ids, raw.document_ids + raw.size, id) - raw.document_ids;
+    if (position < raw.size && raw.document_ids[position] == id)
+    {
+        raw.word_counts[position] = word_count;
+        raw.document_lengths[position] = document_length;
+        ReplaceBlock(block_index, EncodeRaw(raw, 0, raw.size));
+        return;
+    }
+
+    std::copy_backward(raw.document_ids + position, raw.document_ids + raw.size, raw.document_ids + raw.size + 1);
+    std::copy_backward(raw.word_counts + position, raw.word_counts + raw.size, raw.word_counts + raw.size + 1);
+    std::copy_backward(raw.document_lengths + position, raw.document_lengths + raw.size, raw.document_lengths + raw.size + 1);
+    raw.document_ids[position] = id;
+    raw.word_counts[position] = word_count;
+    raw.document_lengths[position] = document_length;
+    ++raw.size;
+    ++size_;
+
+    if (raw.size <= BLOCK_SIZE)
+    {
+        ReplaceBlock(block_index, EncodeRaw(raw, 0, raw.size));
+        return;
+    }
+    const size_t half = raw.size / 2;
+    ReplaceBlock(block_index, EncodeRaw(raw, 0, half));
+    InsertBlock(block_index + 1, EncodeRaw(raw, half, raw.size));
+}
+
+bool PostingList::Erase(int document_id)
+{
+    if (blocks_.empty())
+    {
+        return false;
+    }
+    const size_t block_index = FindBlock(document_id);
+    const Block& block = blocks_[block_index];
+    if (document_id < block.first_document_id || document_id > block.last_document_id)
+    {
+        return false;
+    }
+
+    RawBlock raw;
+    DecodeRaw(block, raw);
+    const uint32_t id = static_cast<uint32_t>(document_id);
+    const size_t position = std::lower_bound(raw.document_ids, raw.document_ids + raw.size, id) - raw.document_ids;
+    if (position == raw.size || raw.document_ids[position] != id)
+    {
+        return false;
+    }
+
+    std::copy(raw.document_ids + position + 1, raw.document_ids + raw.size, raw.document_ids + position);
+    std::copy(raw.word_counts + position + 1, raw.word_counts + raw.size, raw.word_counts + position);
+    std::copy(raw.document_lengths + position + 1, raw.document_lengths + raw.size, raw.document_lengths + position);
+    --raw.size;
+    --size_;
+
+    if (raw.size == 0)
+    {
+        EraseBlock(block_index);
+    }
+    else
+    {
+        ReplaceBlock(block_index, EncodeRaw(raw, 0, raw.size));
+    }
+    return true;
+}
+
+size_t PostingList::Erase(std::vector<int>::const_iterator first, std::vector<int>::const_iterator last)
+{
+    const size_t old_size = size_;
+    // Blocks that keep postings are compacted to the front, emptied ones are dropped at the end
+    size_t kept_block_count = 0;
+    RawBlock raw;
+    for (size_t block_index = 0; block_index < blocks_.size(); ++block_index)
+    {
+        first = std::lower_bound(first, last, blocks_[block_index].first_document_id);
+        if (first != last && *first <= blocks_[block_index].last_document_id)
+        {
+            DecodeRaw(blocks_[block_index], raw);
+            size_t kept_count = 0;
+            for (size_t i = 0; i < raw.size; ++i)
+            {
+                const int document_id = static_cast<int>(raw.document_ids[i]);
+                first = std::lower_bound(first, last, document_id);
+                if (first != last && *first == document_id)
+                {
+                    continue;
+                }
+                raw.document_ids[kept_count] = raw.document_ids[i];
+                raw.word_counts[kept_count] = raw.word_counts[i];
+                raw.document_lengths[kept_count] = raw.document_lengths[i];
+                ++kept_count;
+            }
+            size_ -= raw.size - kept_count;
+            if (kept_count == 0)
+            {
+                ReplaceBlock(block_index, Block(blocks_.get_allocator()));
+                continue;
+            }
+            ReplaceBlock(block_index, EncodeRaw(raw, 0, kept_count));
+        }
+        if (kept_block_count != block_index)
+        {
+            blocks_[kept_block_count] = std::move(blocks_[block_index]);
+        }
+        ++kept_block_count;
+    }
+    // The blocks left behind were moved from or emptied, they hold no data
+    blocks_.erase(blocks_.begin() + kept_block_count, blocks_.end());
+    return old_size - size_;
+}
+
+bool PostingList::Contains(int document_id) const
+{
+    if (blocks_.empty())
+    {
+        return false;
+    }
+    const Block& block = blocks_[FindBlock(document_id)];
+    if (document_id < block.first_document_id || document_id > block.last_document_id)
+    {
+        return false;
+    }
+    RawBlock raw;
+    DecodeRaw(block, raw);
+    return std::binary_search(raw.document_ids, raw.document_ids + raw.size, static_cast<uint32_t>(document_id));
+}
+
+size_t PostingList::size() const
+{
+    return size_;
+}
+
+bool PostingList::empty() const
+{
+    return size_ == 0;
+}
+
+size_t PostingList::GetBlockCount() const
+{
+    return blocks_.size();
+}
+
+size_t PostingList::GetBlockSize(size_t block_index) const
+{
+    return blocks_[block_index].size;
+}
+
+int PostingList::GetBlockFirstDocumentId(size_t block_index) const
+{
+    return blocks_[block_index].first_document_id;
+}
+
+size_t PostingList::LowerBoundBlock(int document_id) const
+{
+    return std::lower_bound(blocks_.begin(), blocks_.end(), document_id,
+        [](const Block& block, int id) { return block.last_document_id < id; }) - blocks_.begin();
+}
+
+void PostingList::DecodeBlock(size_t block_index, DecodedBlock& decoded) const
+{
+    RawBlock raw;
+    DecodeRaw(blocks_[block_index], raw);
+    decoded.size = raw.size;
+    for (size_t i = 0; i < raw.size; ++i)
+    {
+        decoded.document_ids[i] = static_cast<int>(raw.document_ids[i]);
+        decoded.term_freqs[i] = static_cast<double>(raw.word_counts[i]) / static_cast<double>(raw.document_lengths[i]);
+    }
+}
+
+size_t PostingList::GetEncodedBytes() const
+{
+    size_t bytes = 0;
+    for (const Block& block : blocks_)
+    {
+        bytes += block.data.size();
+    }
+    return bytes;
+}
+
+size_t PostingList::GetMemoryBytes() const
+{
+    return GetHeapBlockBytes(blocks_.capacity() * sizeof(Block)) + block_heap_bytes_;
+}
+
+size_t PostingList::FindBlock(int document_id) const
+{
+    const auto it = std::lower_bound(blocks_.begin(), blocks_.end(), document_id,
+        [](const Block& block, int id) { return block.last_document_id < id; });
+    return it == blocks_.end() ? blocks_.size() - 1 : static_cast<size_t>(it - blocks_.begin());
+}
+
+void PostingList::InsertBlock(size_t block_index, Block block)
+{
+    block_heap_bytes_ += GetHeapBlockBytes(block.data.capacity());
+    blocks_.insert(blocks_.begin() + block_index, std::move(block));
+}
+
+void PostingList::ReplaceBlock(size_t block_index, Block block)
+{
+    block_heap_bytes_ -= GetHeapBlockBytes(blocks_[block_index].data.capacity());
+    block_heap_bytes_ += GetHeapBlockBytes(block.data.capacity());
+    blocks_[block_index] = std::move(block);
+}
+
+void PostingList::EraseBlock(size_t block_index)
+{
+    block_heap_bytes_ -= GetHeapBlockBytes(blocks_[block_index].data.capacity());
+    blocks_.erase(blocks_.begin() + block_index);
+}
+
+void PostingList::DecodeRaw(const Block& block, RawBlock& raw)
+{
+    raw.size = block.size;
+    GetGroupsDecoder()(block.data.data(), block.data.data() + block.data.size(), block.size,
+        raw.document_ids, raw.word_counts, raw.document_lengths);
+    uint32_t document_id = static_cast<uint32_t>(block.first_document_id);
+    for (size_t i = 0; i < raw.size; ++i)
+    {
+        document_id += raw.document_ids[i];
+        raw.document_ids[i] = document_id;
+    }
+}
+
+PostingList::Block PostingList::EncodeRaw(const RawBlock& raw, size_t begin, size_t end) const
+{
+    Block block(blocks_.get_allocator());
+    block.first_document_id = static_cast<int>(raw.document_ids[begin]);
+    block.last_document_id = static_cast<int>(raw.document_ids[end - 1]);
+    block.size = static_cast<uint32_t>(end - begin);
+
+    uint8_t buffer[MAX_BLOCK_BYTES];
+    size_t length = 0;
+    uint32_t gaps[GROUP_SIZE];
+    for (size_t i = begin; i < end; i += GROUP_SIZE)
+    {
+        const size_t count = std::min(GROUP_SIZE, end - i);
+        for (size_t j = 0; j < count; ++j)
+        {
+            gaps[j] = raw.document_ids[i + j] - (i + j == begin ? raw.document_ids[begin] : raw.document_ids[i + j - 1]);
+        }
+        length += EncodeGroup(gaps, count, buffer + length);
+        length += EncodeGroup(raw.word_counts + i, count, buffer + length);
+        length += EncodeGroup(raw.document_lengths + i, count, buffer + length);
+    }
+    block.data.assign(buffer, buffer + length);
+    return block;
+}
@@ -0,0 +1,165 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+// Postings of one word: ascending document ids with the term frequency of the word in each of them.
+// Postings are kept in blocks of up to BLOCK_SIZE. Inside a block the document id gaps, the word counts
+// and the document lengths are group-varint encoded (a tag byte per four values, 1-4 bytes per value),
+// so a typical posting takes 3-4 bytes. Term frequency is restored exactly as word count / document length.
+// Blocks are decoded with SSSE3 shuffles when the CPU supports them.
+class PostingList
+{
+public:
+    static constexpr size_t BLOCK_SIZE = 128;
+
+    // Postings of one block in the form the scoring loop consumes
+    struct DecodedBlock
+    {
+        size_t size = 0;
+        int document_ids[BLOCK_SIZE];
+        double term_freqs[BLOCK_SIZE];
+    };
+
+    // Blocks are allocated from the memory resource of the allocator,
+    // containers of polymorphic allocators pass theirs on construction
+    using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
+    PostingList() = default;
+
+    explicit PostingList(const allocator_type& allocator);
+
+    PostingList(const PostingList& other, const allocator_type& allocator);
+
+    PostingList(PostingList&& other, const allocator_type& allocator);
+
+    PostingList(const PostingList& other) = default;
+
+    PostingList(PostingList&& other) = default;
+
+    PostingList& operator=(const PostingList& other) = default;
+
+    PostingList& operator=(PostingList&& other) = default;
+
+    // Adds the posting or replaces the existing one of the document
+    void Insert(int document_id, uint32_t word_count, uint32_t document_length);
+
+    // Returns false if there is no posting of the document
+    bool Erase(int document_id);
+
+    // Erases the postings of the documents in the sorted range, decoding and encoding every affected block once;
+    // returns the number of erased postings
+    size_t Erase(std::vector<int>::const_iterator first, std::vector<int>::const_iterator last);
+
+    bool Contains(int document_id) const;
+
+    size_t size() const;
+
+    bool empty() const;
+
+    size_t GetBlockCount() const;
+
+    size_t GetBlockSize(size_t block_index) const;
+
+    int GetBlockFirstDocumentId(size_t block_index) const;
+
+    // Index of the first block with a posting of an id from document_id on, GetBlockCount() if there is none
+    size_t LowerBoundBlock(int document_id) const;
+
+    void DecodeBlock(size_t block_index, DecodedBlock& decoded) const;
+
+    // Calls callback(document_id, term_freq) for every posting in the ascending order of ids
+    template <typename Callback>
+    void ForEach(Callback callback) const;
+
+    // Size of the encoded postings, without the block headers
+    size_t GetEncodedBytes() const;
+
+    // Heap memory of the list with the allocator overhead; O(1)
+    size_t GetMemoryBytes() const;
+
+private:
+    // Allocator-aware, so that blocks copied or moved into blocks_ keep their data in its resource
+    struct Block
+    {
+        using allocator_type = PostingList::allocator_type;
+
+        explicit Block(const allocator_type& allocator)
+            : data(allocator)
+        {
+        }
+
+        Block(const Block& other, const allocator_type& allocator)
+            : first_document_id(other.first_document_id)
+            , last_document_id(other.last_document_id)
+            , size(other.size)
+            , data(other.data, allocator)
+        {
+        }
+
+        Block(Block&& other, const allocator_type& allocator)
+            : first_document_id(other.first_document_id)
+            , last_document_id(other.last_document_id)
+            , size(other.size)
+            , data(std::move(other.data), allocator)
+        {
+        }
+
+        Block(const Block& other) = default;
+
+        Block(Block&& other) = default;
+
+        Block& operator=(const Block& other) = default;
+
+        Block& operator=(Block&& other) = default;
+
+        int first_document_id = 0;
+        int last_document_id = 0;
+        uint32_t size = 0;
+        std::pmr::vector<uint8_t> data;
+    };
+
+    // Plain values of one block; one extra slot for an insertion before the block is split
+    struct RawBlock
+    {
+        size_t size = 0;
+        uint32_t document_ids[BLOCK_SIZE + 1];
+        uint32_t word_counts[BLOCK_SIZE + 1];
+        uint32_t document_lengths[BLOCK_SIZE + 1];
+    };
+
+    std::pmr::vector<Block> blocks_;
+    size_t size_ = 0;
+    // Heap memory of the encoded data of all the blocks
+    size_t block_heap_bytes_ = 0;
+
+    // Index of the block that holds or would hold the document
+    size_t FindBlock(int document_id) const;
+
+    // Every change of blocks_ goes through these to keep block_heap_bytes_
+    void InsertBlock(size_t block_index, Block block);
+
+    void ReplaceBlock(size_t block_index, Block block);
+
+    void EraseBlock(size_t block_index);
+
+    static void DecodeRaw(const Block& block, RawBlock& raw);
+
+    // The block takes memory from the resource of the list
+    Block EncodeRaw(const RawBlock& raw, size_t begin, size_t end) const;
+};
+
+template <typename Callback>
+void PostingList::ForEach(Callback callback) const
+{
+    DecodedBlock decoded;
+    for (size_t block_index = 0; block_index < blocks_.size(); ++block_index)
+    {
+        DecodeBlock(block_index, decoded);
+        for (size_t i = 0; i < decoded.size; ++i)
+        {
+            callback(decoded.document_ids[i], decoded.term_freqs[i]);
+        }
+    }
+}
@@ -5,14 +5,9 @@ std::vector<std::vector<Document>> ProcessQueries(
     const std::vector<std::string>& queries)
 {
     std::vector<std::vector<Document>> process_queries(queries.size());
-    std::transform
-    (
-        std::execution::par, 
-        queries.begin(), queries.end(), 
-        process_queries.begin(), 
-        [&search_server](const std::string& querie) 
-        { return search_server.FindTopDocuments(querie); }
-    );
+    search_server.GetThreadPool().ParallelFor(0, queries.size(),
+        [&search_server, &queries, &process_queries](size_t i)
+        { process_queries[i] = search_server.FindTopDocuments(queries[i]); });
     return process_queries;
 }
 
@@ -0,0 +1,47 @@
+#include "query_budget.h"
+
+void CancellationToken::Cancel()
+{
+    cancelled_->store(true, std::memory_order_relaxed);
+}
+
+bool CancellationToken::IsCancelled() const
+{
+    return cancelled_->load(std::memory_order_relaxed);
+}
+
+QueryBudget::QueryBudget(const QueryOptions& options)
+    : options_(options)
+{
+}
+
+size_t QueryBudget::Charge(size_t postings)
+{
+    if (exhausted_)
+    {
+        return 0;
+    }
+    if (options_.cancellation.IsCancelled()
+        || (options_.deadline != std::chrono::steady_clock::time_point::max() && std::chrono::steady_clock::now() >= options_.deadline))
+    {
+        exhausted_ = true;
+        return 0;
+    }
+    if (options_.posting_budget > 0 && charged_postings_ + postings > options_.posting_budget)
+    {
+        postings = options_.posting_budget - charged_postings_;
+        exhausted_ = true;
+    }
+    charged_postings_ += postings;
+    return postings;
+}
+
+bool QueryBudget::IsExhausted() const
+{
+    return exhausted_;
+}
+
+size_t QueryBudget::GetChargedPostings() const
+{
+    return charged_postings_;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include "document.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+// Shared flag: copies of a token observe the same cancellation
+class CancellationToken
+{
+public:
+    void Cancel();
+
+    bool IsCancelled() const;
+
+private:
+    std::shared_ptr<std::atomic<bool>> cancelled_ = std::make_shared<std::atomic<bool>>(false);
+};
+
+// Limits of a single search; a query that hits one of them stops scoring and returns what it has
+struct QueryOptions
+{
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    // Postings a query may score, 0 for no limit
+    size_t posting_budget = 0;
+    CancellationToken cancellation;
+};
+
+struct SearchResult
+{
+    std::vector<Document> documents;
+    // The search was cut short: documents are the best of the postings scored before the stop,
+    // their relevance may be lower than the full one
+    bool is_partial = false;
+    size_t scored_postings = 0;
+};
+
+// Tracks the limits of one query; checked once per posting block
+class QueryBudget
+{
+public:
+    explicit QueryBudget(const QueryOptions& options);
+
+    // Asks for `postings` more postings and returns how many of them the query may score: fewer once
+    // the posting budget runs out, 0 once the deadline has passed or the query is cancelled
+    size_t Charge(size_t postings);
+
+    bool IsExhausted() const;
+
+    size_t GetChargedPostings() const;
+
+private:
+    const QueryOptions& options_;
+    size_t charged_postings_ = 0;
+    bool exhausted_ = false;
+};
@@ -0,0 +1,75 @@
+#include "query_parser.h"
+#include <algorithm>
+#include <numeric>
+
+bool IsValidWord(std::string_view word)
+{
+    return std::none_of(word.begin(), word.end(), [](char c)
+    {
+        return c >= '\0' && c < ' ';
+    });
+}
+
+std::vector<std::string_view> SplitIntoWordsNoStop(std::string_view text, const StopWords& stop_words)
+{
+    std::vector<std::string_view> words;
+    for (const std::string_view word : SplitIntoWords(text))
+    {
+        if (stop_words.count(word) == 0)
+        {
+            words.push_back(word);
+        }
+    }
+    return words;
+}
+
+ParsedQuery ParseQueryText(std::string_view text, const StopWords& stop_words)
+{
+    using namespace std::string_literals;
+    ParsedQuery query;
+    for (std::string_view word : SplitIntoWords(text))
+    {
+        if (!IsValidWord(word))
+        {
+            throw std::invalid_argument("Query contains invalid characters"s);
+        }
+        // Word shouldn't be empty
+        const bool is_minus = word[0] == '-';
+        if (is_minus)
+        {
+            word.remove_prefix(1);
+        }
+        if (stop_words.count(word) > 0)
+        {
+            continue;
+        }
+        if (!is_minus)
+        {
+            query.plus_words.push_back(word);
+            continue;
+        }
+        if (word.empty())
+        {
+            throw std::invalid_argument("No text after the minus sign"s);
+        }
+        if (word[0] == '-')
+        {
+            throw std::invalid_argument("More than one minus sign before the words"s);
+        }
+        query.minus_words.push_back(word);
+    }
+
+    std::sort(query.plus_words.begin(), query.plus_words.end());
+    query.plus_words.erase(std::unique(query.plus_words.begin(), query.plus_words.end()), query.plus_words.end());
+    return query;
+}
+
+int ComputeAverageRating(const std::vector<int>& ratings)
+{
+    if (ratings.empty())
+    {
+        return 0;
+    }
+    const int rating_sum = std::accumulate(ratings.begin(), ratings.end(), 0);
+    return rating_sum / static_cast<int>(ratings.size());
+}
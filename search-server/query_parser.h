@@ -0,0 +1,46 @@
+#pragma once
+#include "string_processing.h"
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Word rules, query syntax and rating of SearchServer and SegmentedIndex, kept in one place so the two engines agree
+
+using StopWords = std::set<std::string, std::less<>>;
+
+// A valid word must not contain special characters
+bool IsValidWord(std::string_view word);
+
+// invalid_argument if a stop word contains special characters
+template <typename StringContainer>
+StopWords MakeStopWords(const StringContainer& stop_words)
+{
+    using namespace std::string_literals;
+    StopWords unique_stop_words = MakeUniqueNonEmptyStrings(stop_words);
+    for (const std::string& stop_word : unique_stop_words)
+    {
+        if (!IsValidWord(stop_word))
+        {
+            throw std::invalid_argument("Stop word contains invalid characters"s);
+        }
+    }
+    return unique_stop_words;
+}
+
+std::vector<std::string_view> SplitIntoWordsNoStop(std::string_view text, const StopWords& stop_words);
+
+struct ParsedQuery
+{
+    // Sorted and unique
+    std::vector<std::string_view> plus_words;
+    std::vector<std::string_view> minus_words;
+};
+
+// Words prefixed with '-' are minus words; stop words are dropped.
+// invalid_argument for special characters, a lone '-' or a word after "--"
+ParsedQuery ParseQueryText(std::string_view text, const StopWords& stop_words);
+
+// Integer mean, 0 for no ratings
+int ComputeAverageRating(const std::vector<int>& ratings);
@@ -0,0 +1,57 @@
+#include "query_planner.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace
+{
+    // Relative cost of a posting: term-at-a-time pays a search in the accumulator tree, about
+    // log2(candidates) dependent cache misses; document-at-a-time pays a comparison with the head
+    // of every list, which stays in cache
+    constexpr double ACCUMULATOR_STEP_COST = 4.0;
+    constexpr double CURSOR_COST = 1.0;
+}
+
+QueryPlan MakeQueryPlan(std::vector<PlannedTerm> plus_terms, std::vector<const PostingList*> minus_postings,
+    double min_inverse_document_freq)
+{
+    QueryPlan plan;
+    for (const PlannedTerm& term : plus_terms)
+    {
+        if (term.inverse_document_freq >= min_inverse_document_freq)
+        {
+            plan.plus_terms.push_back(term);
+            plan.plus_posting_count += term.postings->size();
+        }
+    }
+    std::stable_sort(plan.plus_terms.begin(), plan.plus_terms.end(),
+        [](const PlannedTerm& lhs, const PlannedTerm& rhs) { return lhs.postings->size() < rhs.postings->size(); });
+    // The shortest minus lists are merged first, the exclusion set grows as late as possible
+    std::sort(minus_postings.begin(), minus_postings.end(),
+        [](const PostingList* lhs, const PostingList* rhs) { return lhs->size() < rhs->size(); });
+    plan.minus_postings = std::move(minus_postings);
+
+    // Every posting may start a candidate, so the accumulator holds up to plus_posting_count of them
+    const double term_at_a_time_cost = ACCUMULATOR_STEP_COST * std::log2(plan.plus_posting_count + 2.0);
+    const double document_at_a_time_cost = CURSOR_COST * plan.plus_terms.size();
+    plan.strategy = document_at_a_time_cost <= term_at_a_time_cost
+        ? ScoringStrategy::DOCUMENT_AT_A_TIME
+        : ScoringStrategy::TERM_AT_A_TIME;
+    return plan;
+}
+
+std::vector<int> CollectDocumentIds(const std::vector<const PostingList*>& postings)
+{
+    std::vector<int> document_ids;
+    std::vector<int> list_ids;
+    std::vector<int> merged;
+    for (const PostingList* list : postings)
+    {
+        list_ids.clear();
+        list->ForEach([&list_ids](int document_id, double) { list_ids.push_back(document_id); });
+        merged.clear();
+        std::set_union(document_ids.begin(), document_ids.end(), list_ids.begin(), list_ids.end(), std::back_inserter(merged));
+        document_ids.swap(merged);
+    }
+    return document_ids;
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include "posting_list.h"
+#include <algorithm>
+#include <vector>
+
+// A plus word of a query with its posting list and weight
+struct PlannedTerm
+{
+    const PostingList* postings;
+    double inverse_document_freq;
+};
+
+enum class ScoringStrategy
+{
+    // One posting list after another into an accumulator of partial scores
+    TERM_AT_A_TIME,
+    // All posting lists at once in the order of ids, every document is scored completely when it is met
+    DOCUMENT_AT_A_TIME,
+};
+
+struct QueryPlan
+{
+    // Shortest posting lists first
+    std::vector<PlannedTerm> plus_terms;
+    std::vector<const PostingList*> minus_postings;
+    ScoringStrategy strategy = ScoringStrategy::TERM_AT_A_TIME;
+    // Postings the plus terms will read
+    size_t plus_posting_count = 0;
+};
+
+// Orders the terms by posting length, drops plus terms weighing less than min_inverse_document_freq
+// and picks the cheaper scoring strategy for the remaining ones
+QueryPlan MakeQueryPlan(std::vector<PlannedTerm> plus_terms, std::vector<const PostingList*> minus_postings,
+    double min_inverse_document_freq);
+
+// Sorted ids of the documents that have a posting in any of the lists
+std::vector<int> CollectDocumentIds(const std::vector<const PostingList*>& postings);
+
+// Calls on_document(document_id, relevance) in the ascending order of ids for every document
+// of the plus terms that is not in the sorted `excluded`; relevance sums the terms in plan order
+template <typename OnDocument>
+void ScoreDocumentAtATime(const std::vector<PlannedTerm>& terms, const std::vector<int>& excluded, OnDocument on_document)
+{
+    struct Cursor
+    {
+        const PlannedTerm* term;
+        size_t block_index = 0;
+        size_t position = 0;
+        PostingList::DecodedBlock block;
+
+        bool IsExhausted() const
+        {
+            return position == block.size;
+        }
+
+        int GetDocumentId() const
+        {
+            return block.document_ids[position];
+        }
+
+        void Advance()
+        {
+            if (++position == block.size && ++block_index < term->postings->GetBlockCount())
+            {
+                term->postings->DecodeBlock(block_index, block);
+                position = 0;
+            }
+        }
+    };
+
+    std::vector<Cursor> cursors(terms.size());
+    for (size_t i = 0; i < terms.size(); ++i)
+    {
+        cursors[i].term = &terms[i];
+        if (terms[i].postings->GetBlockCount() > 0)
+        {
+            terms[i].postings->DecodeBlock(0, cursors[i].block);
+        }
+    }
+
+    auto excluded_position = excluded.begin();
+    while (true)
+    {
+        bool has_document = false;
+        int document_id = 0;
+        for (const Cursor& cursor : cursors)
+        {
+            if (!cursor.IsExhausted() && (!has_document || cursor.GetDocumentId() < document_id))
+            {
+                document_id = cursor.GetDocumentId();
+                has_document = true;
+            }
+        }
+        if (!has_document)
+        {
+            return;
+        }
+
+        double relevance = 0.0;
+        for (Cursor& cursor : cursors)
+        {
+            if (!cursor.IsExhausted() && cursor.GetDocumentId() == document_id)
+            {
+                relevance += cursor.block.term_freqs[cursor.position] * cursor.term->inverse_document_freq;
+                cursor.Advance();
+            }
+        }
+        excluded_position = std::lower_bound(excluded_position, excluded.end(), document_id);
+        if (excluded_position == excluded.end() || *excluded_position != document_id)
+        {
+            on_document(document_id, relevance);
+        }
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <chrono>
+
+// Opt-in accounting of the time FindTopDocuments spends in each stage.
+// Recording is enabled for the current thread only, while a QueryStageRecorder is alive;
+// otherwise the cost is one thread-local pointer check per stage.
+
+struct QueryStageTimes
+{
+    std::chrono::nanoseconds parse{};
+    std::chrono::nanoseconds score{};
+    std::chrono::nanoseconds rank{};
+    size_t queries = 0;
+};
+
+inline thread_local QueryStageTimes* current_query_stage_times = nullptr;
+
+class QueryStageRecorder
+{
+public:
+    explicit QueryStageRecorder(QueryStageTimes& times)
+        : previous_(current_query_stage_times)
+    {
+        current_query_stage_times = &times;
+    }
+
+    QueryStageRecorder(const QueryStageRecorder&) = delete;
+    QueryStageRecorder& operator=(const QueryStageRecorder&) = delete;
+
+    ~QueryStageRecorder()
+    {
+        current_query_stage_times = previous_;
+    }
+
+private:
+    QueryStageTimes* previous_;
+};
+
+class QueryStageTimer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit QueryStageTimer(std::chrono::nanoseconds QueryStageTimes::* stage)
+        : times_(current_query_stage_times)
+        , stage_(stage)
+    {
+        if (times_)
+        {
+            start_time_ = Clock::now();
+        }
+    }
+
+    QueryStageTimer(const QueryStageTimer&) = delete;
+    QueryStageTimer& operator=(const QueryStageTimer&) = delete;
+
+    ~QueryStageTimer()
+    {
+        if (times_)
+        {
+            times_->*stage_ += Clock::now() - start_time_;
+        }
+    }
+
+private:
+    QueryStageTimes* times_;
+    std::chrono::nanoseconds QueryStageTimes::* stage_;
+    Clock::time_point start_time_;
+};
@@ -3,7 +3,7 @@
 std::set<std::string_view> GetDocumentWords(SearchServer& search_server, int document_id)
 {
     std::set<std::string_view> document_words;
-    std::map<std::string_view, double> words_frequencies = search_server.GetWordFrequencies(document_id);
+    const auto& words_frequencies = search_server.GetWordFrequencies(document_id);
     for (auto& [word, freqs] : words_frequencies)
     {
         document_words.insert(word);
@@ -29,9 +29,6 @@ void RemoveDuplicates(SearchServer& search_server)
             documents_words.insert(current_words);
         }
     }
-    
-    for (int document_to_delete : documents_to_delete)
-    {
-        search_server.RemoveDocument(document_to_delete);
-    }
+
+    search_server.RemoveDocuments(std::vector<int>(documents_to_delete.begin(), documents_to_delete.end()));
 }
\ No newline at end of file
@@ -0,0 +1,209 @@
+#include "scoring_kernel.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define SCORING_KERNEL_X86
+#include <immintrin.h>
+#endif
+
+// The products and the sums of the vector code must round as the scalar ones do: no fused multiply-add
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+namespace
+{
+    template <typename Score>
+    struct Kernels
+    {
+        using Accumulate = void (*)(const int*, const double*, size_t, int, Score, Score*);
+    };
+
+    template <typename Score>
+    void AccumulateScalar(const int* document_ids, const double* term_freqs, size_t count, int base, Score weight, Score* scores)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            scores[document_ids[i] - base] += static_cast<Score>(term_freqs[i]) * weight;
+        }
+    }
+
+#ifdef SCORING_KERNEL_X86
+    // AVX2 has gathers but no scatters: the products are vectorized, the additions stay scalar
+    __attribute__((target("avx2")))
+    void AccumulateAvx2(const int* document_ids, const double* term_freqs, size_t count, int base, double weight, double* scores)
+    {
+        const __m256d weights = _mm256_set1_pd(weight);
+        alignas(32) double products[4];
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            _mm256_store_pd(products, _mm256_mul_pd(_mm256_loadu_pd(term_freqs + i), weights));
+            for (size_t lane = 0; lane < 4; ++lane)
+            {
+                scores[document_ids[i + lane] - base] += products[lane];
+            }
+        }
+        AccumulateScalar(document_ids + i, term_freqs + i, count - i, base, weight, scores);
+    }
+
+    __attribute__((target("avx2")))
+    void AccumulateAvx2(const int* document_ids, const double* term_freqs, size_t count, int base, float weight, float* scores)
+    {
+        const __m256 weights = _mm256_set1_ps(weight);
+        alignas(32) float products[8];
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m256 freqs = _mm256_set_m128(_mm256_cvtpd_ps(_mm256_loadu_pd(term_freqs + i + 4)),
+                _mm256_cvtpd_ps(_mm256_loadu_pd(term_freqs + i)));
+            _mm256_store_ps(products, _mm256_mul_ps(freqs, weights));
+            for (size_t lane = 0; lane < 8; ++lane)
+            {
+                scores[document_ids[i + lane] - base] += products[lane];
+            }
+        }
+        AccumulateScalar(document_ids + i, term_freqs + i, count - i, base, weight, scores);
+    }
+
+    // Gather, add, scatter; the ids of one call are distinct, so the lanes of a scatter never collide.
+    // Gathers take a zero source with a full mask for the reason given at LoadFloatFreqs
+    __attribute__((target("avx512f")))
+    void AccumulateAvx512(const int* document_ids, const double* term_freqs, size_t count, int base, double weight, double* scores)
+    {
+        const __m512d weights = _mm512_set1_pd(weight);
+        const __m256i bases = _mm256_set1_epi32(base);
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m256i slots = _mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(document_ids + i)), bases);
+            const __m512d products = _mm512_mul_pd(_mm512_loadu_pd(term_freqs + i), weights);
+            const __m512d sums = _mm512_add_pd(_mm512_mask_i32gather_pd(_mm512_setzero_pd(), 0xFF, slots, scores, sizeof(double)), products);
+            _mm512_i32scatter_pd(scores, slots, sums, sizeof(double));
+        }
+        AccumulateScalar(document_ids + i, term_freqs + i, count - i, base, weight, scores);
+    }
+
+    // Sixteen term frequencies rounded to float. The masked forms have a defined source for every lane,
+    // the plain ones leave it undefined, which GCC reports as maybe uninitialized
+    __attribute__((target("avx512f")))
+    inline __m512 LoadFloatFreqs(const double* term_freqs)
+    {
+        const __m512d zeros = _mm512_setzero_pd();
+        const __m256 low = _mm512_maskz_cvtpd_ps(0xFF, _mm512_loadu_pd(term_freqs));
+        const __m256 high = _mm512_maskz_cvtpd_ps(0xFF, _mm512_loadu_pd(term_freqs + 8));
+        const __m512d halves = _mm512_mask_insertf64x4(zeros, 0xFF, zeros, _mm256_castps_pd(low), 0);
+        return _mm512_castpd_ps(_mm512_mask_insertf64x4(zeros, 0xFF, halves, _mm256_castps_pd(high), 1));
+    }
+
+    __attribute__((target("avx512f")))
+    void AccumulateAvx512(const int* document_ids, const double* term_freqs, size_t count, int base, float weight, float* scores)
+    {
+        const __m512 weights = _mm512_set1_ps(weight);
+        const __m512i bases = _mm512_set1_epi32(base);
+        size_t i = 0;
+        for (; i + 16 <= count; i += 16)
+        {
+            const __m512i slots = _mm512_sub_epi32(_mm512_loadu_si512(document_ids + i), bases);
+            const __m512 products = _mm512_mul_ps(LoadFloatFreqs(term_freqs + i), weights);
+            const __m512 sums = _mm512_add_ps(_mm512_mask_i32gather_ps(_mm512_setzero_ps(), 0xFFFF, slots, scores, sizeof(float)), products);
+            _mm512_i32scatter_ps(scores, slots, sums, sizeof(float));
+        }
+        AccumulateScalar(document_ids + i, term_freqs + i, count - i, base, weight, scores);
+    }
+#endif
+
+    ScoringKernel ChooseScoringKernel()
+    {
+        if (IsScoringKernelSupported(ScoringKernel::AVX512))
+        {
+            return ScoringKernel::AVX512;
+        }
+        if (IsScoringKernelSupported(ScoringKernel::AVX2))
+        {
+            return ScoringKernel::AVX2;
+        }
+        return ScoringKernel::SCALAR;
+    }
+
+    ScoringKernel GetScoringKernel()
+    {
+        static const ScoringKernel kernel = ChooseScoringKernel();
+        return kernel;
+    }
+
+    template <typename Score>
+    typename Kernels<Score>::Accumulate GetKernel(ScoringKernel kernel)
+    {
+#ifdef SCORING_KERNEL_X86
+        switch (kernel)
+        {
+        case ScoringKernel::AVX512:
+            return AccumulateAvx512;
+        case ScoringKernel::AVX2:
+            return AccumulateAvx2;
+        default:
+            break;
+        }
+#endif
+        return AccumulateScalar<Score>;
+    }
+
+    template <typename Score>
+    typename Kernels<Score>::Accumulate GetKernel()
+    {
+        static const typename Kernels<Score>::Accumulate kernel = GetKernel<Score>(GetScoringKernel());
+        return kernel;
+    }
+}
+
+void AccumulateScores(const int* document_ids, const double* term_freqs, size_t count, int base, double weight, double* scores)
+{
+    GetKernel<double>()(document_ids, term_freqs, count, base, weight, scores);
+}
+
+void AccumulateScores(const int* document_ids, const double* term_freqs, size_t count, int base, float weight, float* scores)
+{
+    GetKernel<float>()(document_ids, term_freqs, count, base, weight, scores);
+}
+
+void AccumulateScoresWith(ScoringKernel kernel, const int* document_ids, const double* term_freqs, size_t count, int base,
+    double weight, double* scores)
+{
+    GetKernel<double>(kernel)(document_ids, term_freqs, count, base, weight, scores);
+}
+
+void AccumulateScoresWith(ScoringKernel kernel, const int* document_ids, const double* term_freqs, size_t count, int base,
+    float weight, float* scores)
+{
+    GetKernel<float>(kernel)(document_ids, term_freqs, count, base, weight, scores);
+}
+
+bool IsScoringKernelSupported(ScoringKernel kernel)
+{
+    switch (kernel)
+    {
+#ifdef SCORING_KERNEL_X86
+    case ScoringKernel::AVX512:
+        return __builtin_cpu_supports("avx512f");
+    case ScoringKernel::AVX2:
+        return __builtin_cpu_supports("avx2");
+#endif
+    case ScoringKernel::SCALAR:
+        return true;
+    default:
+        return false;
+    }
+}
+
+const char* GetScoringKernelName()
+{
+    switch (GetScoringKernel())
+    {
+    case ScoringKernel::AVX512:
+        return "avx512";
+    case ScoringKernel::AVX2:
+        return "avx2";
+    default:
+        return "scalar";
+    }
+}
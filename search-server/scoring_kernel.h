@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+
+// Type of the relevance accumulators of term-at-a-time scoring
+enum class ScorePrecision
+{
+    // Sums are the same as those of the map-based scoring, bit for bit
+    DOUBLE,
+    // Half the accumulator memory traffic per posting. A term is off by three roundings to float (term frequency,
+    // IDF, product) and every addition by one, each at most 2^-24 relative, so a relevance of k terms differs
+    // from the DOUBLE one by at most k * 2^-22 * relevance: 7.2e-7 for three terms and a relevance of 1, less
+    // than COMPARISON_ACCURACY. Only documents whose relevances differ by about COMPARISON_ACCURACY may tie with
+    // one precision and not with the other, and so rank differently than with DOUBLE.
+    FLOAT,
+};
+
+// scores[document_ids[i] - base] += term_freqs[i] * weight for i in [0, count).
+// The ids must be distinct, as those of one posting block are. Runs on AVX-512 or AVX2
+// when the CPU has them; the products are rounded as in the scalar code, the sums are identical.
+void AccumulateScores(const int* document_ids, const double* term_freqs, size_t count, int base, double weight, double* scores);
+
+// Term frequencies are rounded to float before the product
+void AccumulateScores(const int* document_ids, const double* term_freqs, size_t count, int base, float weight, float* scores);
+
+enum class ScoringKernel
+{
+    SCALAR,
+    AVX2,
+    AVX512,
+};
+
+// SCALAR runs everywhere
+bool IsScoringKernelSupported(ScoringKernel kernel);
+
+// AccumulateScores on the given kernel, which the CPU must support; to compare the kernels with each other
+void AccumulateScoresWith(ScoringKernel kernel, const int* document_ids, const double* term_freqs, size_t count, int base,
+    double weight, double* scores);
+
+void AccumulateScoresWith(ScoringKernel kernel, const int* document_ids, const double* term_freqs, size_t count, int base,
+    float weight, float* scores);
+
+// Of the kernel chosen by AccumulateScores: "avx512", "avx2" or "scalar"
+const char* GetScoringKernelName();
@@ -0,0 +1,67 @@
+#include "search_cursor.h"
+#include "search_server.h"
+
+namespace
+{
+    // Heap order of std::make_heap: the document paged first is the greatest
+    bool IsPagedAfter(const Document& lhs, const Document& rhs)
+    {
+        return SearchCursor::IsPagedBefore(rhs, lhs);
+    }
+}
+
+SearchCursor::SearchCursor(std::vector<Document> documents, const std::optional<Document>& after)
+    : documents_(std::move(documents))
+    , last_document_(after)
+{
+    if (after)
+    {
+        documents_.erase(
+            std::remove_if(documents_.begin(), documents_.end(),
+                [&after](const Document& document) { return !IsPagedBefore(*after, document); }),
+            documents_.end());
+    }
+    std::make_heap(documents_.begin(), documents_.end(), IsPagedAfter);
+}
+
+std::vector<Document> SearchCursor::NextPage(size_t page_size)
+{
+    std::vector<Document> page;
+    page.reserve(std::min(page_size, documents_.size()));
+    while (page.size() < page_size && !documents_.empty())
+    {
+        std::pop_heap(documents_.begin(), documents_.end(), IsPagedAfter);
+        page.push_back(documents_.back());
+        documents_.pop_back();
+    }
+    if (!page.empty())
+    {
+        last_document_ = page.back();
+    }
+    return page;
+}
+
+bool SearchCursor::IsExhausted() const
+{
+    return documents_.empty();
+}
+
+const std::optional<Document>& SearchCursor::GetLastDocument() const
+{
+    return last_document_;
+}
+
+bool SearchCursor::IsPagedBefore(const Document& lhs, const Document& rhs)
+{
+    const double lhs_relevance = std::floor(lhs.relevance / COMPARISON_ACCURACY);
+    const double rhs_relevance = std::floor(rhs.relevance / COMPARISON_ACCURACY);
+    if (lhs_relevance != rhs_relevance)
+    {
+        return lhs_relevance > rhs_relevance;
+    }
+    if (lhs.rating != rhs.rating)
+    {
+        return lhs.rating > rhs.rating;
+    }
+    return lhs.id < rhs.id;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "document.h"
+#include <optional>
+#include <vector>
+
+// Results of one search kept for search-after pagination: the query is scored once, and every page is taken
+// from the documents not returned yet in O(page_size * log(n)). Documents added or removed after the search
+// are not seen
+class SearchCursor
+{
+public:
+    SearchCursor() = default;
+
+    // Matched documents in any order; those not paged after `after` are dropped
+    SearchCursor(std::vector<Document> documents, const std::optional<Document>& after);
+
+    // Next page_size documents in the page order, fewer at the end
+    std::vector<Document> NextPage(size_t page_size);
+
+    bool IsExhausted() const;
+
+    // Last document returned, std::nullopt before the first page;
+    // SearchServer::FindTopDocumentsAfter continues from it when the cursor can't be kept
+    const std::optional<Document>& GetLastDocument() const;
+
+    // Order of the pages: relevance in steps of COMPARISON_ACCURACY, then rating, then id. Unlike the ranking
+    // of FindTopDocuments it is a strict total order, without which pages skip and repeat documents
+    static bool IsPagedBefore(const Document& lhs, const Document& rhs);
+
+private:
+    // Heap of the documents not returned yet, the next one on top
+    std::vector<Document> documents_;
+    std::optional<Document> last_document_;
+};
@@ -1,28 +1,100 @@
 #include "search_server.h"
 
-SearchServer::SearchServer(const std::string_view stop_words_text)
-    : SearchServer(SplitIntoWords(stop_words_text))
+namespace
 {
+    // Walks the shorter vector and gallops through the longer one, so a short query
+    // against a long document costs O(query * log(document / query)).
+    template <typename Shorter, typename Longer, typename OnMatch>
+    void GallopIntersect(const Shorter& shorter, const Longer& longer, OnMatch& on_match)
+    {
+        auto position = longer.begin();
+        for (const int value : shorter)
+        {
+            auto low = position;
+            size_t step = 1;
+            while (static_cast<size_t>(longer.end() - low) > step && *(low + step) < value)
+            {
+                low += step;
+                step *= 2;
+            }
+            const auto high = static_cast<size_t>(longer.end() - low) > step ? low + step + 1 : longer.end();
+            position = std::lower_bound(low, high, value);
+            if (position == longer.end())
+            {
+                return;
+            }
+            if (*position == value)
+            {
+                on_match(value);
+                ++position;
+            }
+        }
+    }
+
+    // Calls on_match for every value present in both sorted vectors, whatever their allocators
+    template <typename Lhs, typename Rhs, typename OnMatch>
+    void IntersectSorted(const Lhs& lhs, const Rhs& rhs, OnMatch on_match)
+    {
+        if (lhs.size() <= rhs.size())
+        {
+            GallopIntersect(lhs, rhs, on_match);
+        }
+        else
+        {
+            GallopIntersect(rhs, lhs, on_match);
+        }
+    }
 }
 
-SearchServer::SearchServer(const std::string& stop_words_text)
-    : SearchServer(SplitIntoWords(std::string_view(stop_words_text)))  // Invoke delegating constructor from string container
+SearchServer::SearchServer(const std::string_view stop_words_text, const SearchServerOptions& options)
+    : SearchServer(SplitIntoWords(stop_words_text), options)
+{
+}
+
+SearchServer::SearchServer(const std::string& stop_words_text, const SearchServerOptions& options)
+    : SearchServer(SplitIntoWords(std::string_view(stop_words_text)), options)  // Invoke delegating constructor from string container
 {
 }
 
 void SearchServer::AddDocument(int document_id, const std::string_view document, DocumentStatus status, const std::vector<int>& ratings)
 {
     IsValidDocument(document_id, document);
-    documents_.emplace(document_id, DocumentData{ ComputeAverageRating(ratings), status, std::string(document) });
+    impact_index_.reset();
+    documents_.emplace(document_id, DocumentData{ ComputeAverageRating(ratings), status });
     all_documents_id_.insert(document_id);
+    text_store_->Add(document_id, document);
 
-    const std::vector<std::string_view> words = SplitIntoWordsNoStop(std::string_view(documents_.at(document_id).document_view));
-    const double inv_word_count = 1.0 / words.size();
+    const std::vector<std::string_view> words = SplitIntoWordsNoStop(document, stop_words_);
+    const uint32_t document_length = static_cast<uint32_t>(words.size());
+    std::pmr::vector<int>& term_ids = document_to_term_ids_[document_id];
     for (const std::string_view word : words)
     {
-        word_to_document_freqs_[word][document_id] += inv_word_count;
-        document_to_word_freqs_[document_id][word] += inv_word_count;
+        term_ids.push_back(dictionary_.AddTerm(word));
     }
+    std::sort(term_ids.begin(), term_ids.end());
+
+    // Occurrences of a word are adjacent after sorting, the run length is the word count
+    std::pmr::map<std::string_view, double>& word_freqs = document_to_word_freqs_[document_id];
+    for (auto run_begin = term_ids.begin(); run_begin != term_ids.end();)
+    {
+        const auto run_end = std::upper_bound(run_begin, term_ids.end(), *run_begin);
+        const uint32_t word_count = static_cast<uint32_t>(run_end - run_begin);
+        const std::string_view word = dictionary_.GetTerm(*run_begin);
+        const auto [postings, is_new_word] = word_to_document_freqs_.try_emplace(word);
+        if (is_new_word)
+        {
+            memory_usage_.postings += GetTreeNodeBytes<std::pair<const std::string_view, PostingList>>();
+        }
+        // Insert never shrinks the list
+        const size_t posting_bytes = postings->second.GetMemoryBytes();
+        postings->second.Insert(document_id, word_count, document_length);
+        memory_usage_.postings += postings->second.GetMemoryBytes() - posting_bytes;
+        word_freqs[word] = static_cast<double>(word_count) / static_cast<double>(document_length);
+        run_begin = run_end;
+    }
+    term_ids.erase(std::unique(term_ids.begin(), term_ids.end()), term_ids.end());
+    term_ids.shrink_to_fit();
+    memory_usage_ += GetDocumentMemoryUsage(document_id);
 }
 
 // execution::sep, string, status
@@ -39,35 +111,66 @@ std::vector<Document> SearchServer::FindTopDocuments(const std::string_view raw_
     return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
 }
 
+// string, status
+std::vector<Document> SearchServer::FindTopDocumentsByImpact(const std::string_view raw_query, DocumentStatus document_status) const
+{
+    return FindTopDocumentsByImpact(raw_query,
+        [document_status](int document_id, DocumentStatus status, int rating)
+            { return status == document_status; });
+}
+
+// string
+std::vector<Document> SearchServer::FindTopDocumentsByImpact(const std::string_view raw_query) const
+{
+    return FindTopDocumentsByImpact(raw_query, DocumentStatus::ACTUAL);
+}
+
+// string, status, options
+SearchResult SearchServer::FindTopDocumentsWithin(const std::string_view raw_query, DocumentStatus document_status, const QueryOptions& options) const
+{
+    return FindTopDocumentsWithin(raw_query,
+        [document_status](int document_id, DocumentStatus status, int rating)
+            { return status == document_status; },
+        options);
+}
+
+// string, options
+SearchResult SearchServer::FindTopDocumentsWithin(const std::string_view raw_query, const QueryOptions& options) const
+{
+    return FindTopDocumentsWithin(raw_query, DocumentStatus::ACTUAL, options);
+}
+
+// string, status, options
+std::future<SearchResult> SearchServer::FindTopDocumentsAsync(std::string raw_query, DocumentStatus document_status, QueryOptions options) const
+{
+    return FindTopDocumentsAsync(std::move(raw_query),
+        [document_status](int document_id, DocumentStatus status, int rating)
+            { return status == document_status; },
+        std::move(options));
+}
+
+// string, options
+std::future<SearchResult> SearchServer::FindTopDocumentsAsync(std::string raw_query, QueryOptions options) const
+{
+    return FindTopDocumentsAsync(std::move(raw_query), DocumentStatus::ACTUAL, std::move(options));
+}
+
+// execution::sep, string, cursor, int
+std::vector<Document> SearchServer::FindTopDocumentsAfter(const std::string_view raw_query, const std::optional<Document>& after, size_t page_size) const
+{
+    return FindTopDocumentsAfter(std::execution::seq, raw_query, DocumentStatus::ACTUAL, after, page_size);
+}
+
 std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(const std::string_view raw_query, int document_id) const
 {
     IsValidId(document_id);
-    const Query query = ParseQuery(raw_query);
-    std::vector<std::string_view> matched_words;
+    return MatchQueryTerms(ParseQueryTerms(raw_query), document_id);
+}
 
-    for (const std::string_view word : query.minus_words)
-    {
-        if (word_to_document_freqs_.count(word) == 0)
-        {
-            continue;
-        }
-        if (word_to_document_freqs_.at(word).count(document_id))
-        {
-            return { matched_words, documents_.at(document_id).status };
-        }
-    }
-    for (const std::string_view word : query.plus_words)
-    {
-        if (word_to_document_freqs_.count(word) == 0)
-        {
-            continue;
-        }
-        if (word_to_document_freqs_.at(word).count(document_id))
-        {
-            matched_words.push_back(word);
-        }
-    }
-    return { matched_words, documents_.at(document_id).status };
+std::vector<std::tuple<std::vector<std::string_view>, DocumentStatus>> SearchServer::MatchDocuments(
+    const std::string_view raw_query, const std::vector<int>& document_ids) const
+{
+    return MatchDocuments(std::execution::seq, raw_query, document_ids);
 }
 
 int SearchServer::GetDocumentCount() const
@@ -75,19 +178,24 @@ int SearchServer::GetDocumentCount() const
     return documents_.size();
 }
 
-std::set<int>::iterator SearchServer::begin() const
+SearchServer::DocumentIdIterator SearchServer::begin() const
 {
     return all_documents_id_.begin();
 }
 
-std::set<int>::iterator SearchServer::end() const
+SearchServer::DocumentIdIterator SearchServer::end() const
 {
     return all_documents_id_.end();
 }
 
-const std::map<std::string_view, double>& SearchServer::GetWordFrequencies(int document_id) const
+SearchServer::WordFrequencies SearchServer::GetWordFrequencies(int document_id) const
 {
-    return document_to_word_freqs_.at(document_id);
+    return WordFrequencies(document_to_word_freqs_.at(document_id));
+}
+
+std::string SearchServer::GetDocumentText(int document_id) const
+{
+    return text_store_->Get(document_id);
 }
 
 void SearchServer::RemoveDocument(int document_id)
@@ -95,21 +203,103 @@ void SearchServer::RemoveDocument(int document_id)
     RemoveDocument(std::execution::seq, document_id);
 }
 
-// private methods
-bool SearchServer::IsStopWord(const std::string_view word) const
+// ids
+void SearchServer::RemoveDocuments(const std::vector<int>& document_ids)
+{
+    RemoveDocuments(std::execution::seq, document_ids);
+}
+
+void SearchServer::BuildImpactIndex()
+{
+    auto impact_index = std::make_unique<ImpactIndex>();
+    for (const auto& [word, postings] : word_to_document_freqs_)
+    {
+        if (!postings.empty())
+        {
+            impact_index->AddTerm(word, postings);
+        }
+    }
+    impact_index_ = std::move(impact_index);
+}
+
+bool SearchServer::HasImpactIndex() const
+{
+    return impact_index_ != nullptr;
+}
+
+ThreadPool& SearchServer::GetThreadPool() const
 {
-    return stop_words_.count(word) > 0;
+    return *thread_pool_;
 }
 
-bool SearchServer::IsValidWord(const std::string_view word)
+TermFilter::Stats SearchServer::GetTermFilterStats() const
 {
-    // A valid word must not contain special characters
-    return std::none_of(word.begin(), word.end(), [](char c)
+    return dictionary_.GetFilterStats();
+}
+
+MemoryUsage SearchServer::GetMemoryUsage() const
+{
+    MemoryUsage usage = memory_usage_;
+    usage.dictionary = dictionary_.GetMemoryBytes();
+    usage.impact_index = impact_index_ ? impact_index_->GetMemoryBytes() : 0;
+    usage.document_text = text_store_->GetMemoryBytes();
+    // The estimates follow the blocks of the global heap; pools and arenas are measured instead
+    if (options_.allocation != IndexAllocation::GLOBAL_HEAP)
     {
-        return c >= '\0' && c < ' ';
-    });
+        usage.postings = 0;
+        usage.forward_index = 0;
+        usage.document_metadata = 0;
+        usage.index_resource = index_memory_->GetReservedBytes();
+    }
+    return usage;
 }
 
+SearchServer::WordFrequencies::WordFrequencies(const std::pmr::map<std::string_view, double>& word_freqs)
+    : word_freqs_(&word_freqs)
+{
+}
+
+SearchServer::WordFrequencies::const_iterator SearchServer::WordFrequencies::begin() const
+{
+    return word_freqs_->begin();
+}
+
+SearchServer::WordFrequencies::const_iterator SearchServer::WordFrequencies::end() const
+{
+    return word_freqs_->end();
+}
+
+size_t SearchServer::WordFrequencies::size() const
+{
+    return word_freqs_->size();
+}
+
+bool SearchServer::WordFrequencies::empty() const
+{
+    return word_freqs_->empty();
+}
+
+size_t SearchServer::WordFrequencies::count(const std::string_view word) const
+{
+    return word_freqs_->count(word);
+}
+
+SearchServer::WordFrequencies::const_iterator SearchServer::WordFrequencies::find(const std::string_view word) const
+{
+    return word_freqs_->find(word);
+}
+
+double SearchServer::WordFrequencies::at(const std::string_view word) const
+{
+    return word_freqs_->at(word);
+}
+
+SearchServer::WordFrequencies::operator std::map<std::string_view, double>() const
+{
+    return { word_freqs_->begin(), word_freqs_->end() };
+}
+
+// private methods
 void SearchServer::IsValidDocument(int document_id, const std::string_view document) const
 {
     using namespace std::string_literals;
@@ -136,86 +326,168 @@ void SearchServer::IsValidId(int document_id) const
     }
 }
 
-std::vector<std::string_view> SearchServer::SplitIntoWordsNoStop(const std::string_view text) const
+SearchServer::IndexContainers::IndexContainers(std::pmr::memory_resource* resource)
+    : word_to_document_freqs(resource)
+    , document_to_word_freqs(resource)
+    , document_to_term_ids(resource)
+    , documents(resource)
+    , all_documents_id(resource)
 {
-    std::vector<std::string_view> words;
-    for (const std::string_view word : SplitIntoWords(text))
-    {
-        if (!IsStopWord(word))
-        {
-            words.push_back(word);
-        }
-    }
-    return words;
 }
 
-int SearchServer::ComputeAverageRating(const std::vector<int>& ratings)
+void SearchServer::IndexContainersDeleter::operator()(IndexContainers* index) const
 {
-    if (ratings.empty())
+    if (!memory->IsReleasedAtOnce())
     {
-        return 0;
+        index->~IndexContainers();
+        memory->GetResource()->deallocate(index, sizeof(IndexContainers), alignof(IndexContainers));
     }
-    int rating_sum = accumulate(ratings.begin(), ratings.end(), 0);
-    return rating_sum / static_cast<int>(ratings.size());
 }
 
-SearchServer::QueryWord SearchServer::ParseQueryWord(std::string_view text) const
+std::unique_ptr<SearchServer::IndexContainers, SearchServer::IndexContainersDeleter> SearchServer::CreateIndexContainers(const IndexMemory& memory)
+{
+    std::pmr::memory_resource* resource = memory.GetResource();
+    void* place = resource->allocate(sizeof(IndexContainers), alignof(IndexContainers));
+    return { new (place) IndexContainers(resource), IndexContainersDeleter{ &memory } };
+}
+
+MemoryUsage SearchServer::GetDocumentMemoryUsage(int document_id) const
+{
+    MemoryUsage usage;
+    usage.forward_index = GetTreeNodeBytes<decltype(IndexContainers::document_to_word_freqs)::value_type>()
+        + document_to_word_freqs_.at(document_id).size() * GetTreeNodeBytes<std::pair<const std::string_view, double>>()
+        + GetTreeNodeBytes<decltype(IndexContainers::document_to_term_ids)::value_type>()
+        + GetVectorHeapBytes(document_to_term_ids_.at(document_id));
+    usage.document_metadata = GetTreeNodeBytes<decltype(IndexContainers::documents)::value_type>() + GetTreeNodeBytes<int>();
+    return usage;
+}
+
+SearchServer::Query SearchServer::ParseQuery(const std::string_view text) const
 {
-    if (!IsValidWord(text))
+    return ParseQueryText(text, stop_words_);
+}
+
+SearchServer::QueryTerms SearchServer::ParseQueryTerms(const std::string_view text) const
+{
+    const Query query = ParseQuery(text);
+    return { FindTermIds(query.plus_words), FindTermIds(query.minus_words) };
+}
+
+QueryPlan SearchServer::PlanQuery(const Query& query) const
+{
+    std::vector<PlannedTerm> plus_terms;
+    for (const std::string_view word : query.plus_words)
     {
-        using namespace std::string_literals;
-        throw std::invalid_argument("Query contains invalid characters"s);
+        if (const PostingList* postings = FindPostings(word))
+        {
+            plus_terms.push_back({ postings, ComputeWordInverseDocumentFreq(*postings) });
+        }
     }
-    bool is_minus = false;
-    // Word shouldn't be empty
-    if (text[0] == '-')
+    std::vector<const PostingList*> minus_postings;
+    for (const std::string_view word : query.minus_words)
     {
-        is_minus = true;
-        text = text.substr(1);
+        if (const PostingList* postings = FindPostings(word))
+        {
+            minus_postings.push_back(postings);
+        }
     }
-    return { text, is_minus, IsStopWord(text) };
+    return MakeQueryPlan(std::move(plus_terms), std::move(minus_postings),
+        options_.drop_zero_idf_terms ? COMPARISON_ACCURACY : 0.0);
 }
 
-SearchServer::Query SearchServer::ParseQuery(const std::string_view text, bool sequenced_flag) const
+std::vector<int> SearchServer::FindTermIds(const std::vector<std::string_view>& words) const
 {
-    Query query;
-
-    for (std::string_view word : SplitIntoWords(text))
+    std::vector<int> term_ids;
+    term_ids.reserve(words.size());
+    for (const std::string_view word : words)
     {
-        const QueryWord query_word = ParseQueryWord(word);
-        if (!query_word.is_stop)
+        const int term_id = dictionary_.FindTerm(word);
+        if (term_id != TermDictionary::NO_TERM)
         {
-            if (query_word.is_minus)
-            {
-                using namespace std::string_literals;
-                if (query_word.data.empty())
-                {
-                    throw std::invalid_argument("No text after the minus sign"s);
-                }
-                if (query_word.data[0] == '-')
-                {
-                    throw std::invalid_argument("More than one minus sign before the words"s);
-                }
-                query.minus_words.push_back(query_word.data);
-            }
-            else
-            {
-                query.plus_words.push_back(query_word.data);
-            }
+            term_ids.push_back(term_id);
         }
     }
+    std::sort(term_ids.begin(), term_ids.end());
+    term_ids.erase(std::unique(term_ids.begin(), term_ids.end()), term_ids.end());
+    return term_ids;
+}
+
+// Existence required
+std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchQueryTerms(const QueryTerms& query_terms, int document_id) const
+{
+    const std::pmr::vector<int>& document_terms = document_to_term_ids_.at(document_id);
+    const DocumentStatus status = documents_.at(document_id).status;
 
-    if (sequenced_flag)
+    if (ContainsAnyTerm(document_id, query_terms.minus_terms))
     {
-        std::sort(query.plus_words.begin(), query.plus_words.end());
-        auto new_end = unique(query.plus_words.begin(), query.plus_words.end());
-        query.plus_words.erase(new_end, query.plus_words.end());
+        return { std::vector<std::string_view>{}, status };
     }
-    return query;
+
+    std::vector<std::string_view> matched_words;
+    IntersectSorted(query_terms.plus_terms, document_terms,
+        [this, &matched_words](int term_id) { matched_words.push_back(dictionary_.GetTerm(term_id)); });
+    // Term ids follow the order words were first seen in, callers get the words sorted
+    std::sort(matched_words.begin(), matched_words.end());
+    return { matched_words, status };
 }
 
 // Existence required
-double SearchServer::ComputeWordInverseDocumentFreq(const std::string_view word) const
+bool SearchServer::ContainsAnyTerm(int document_id, const std::vector<int>& sorted_term_ids) const
+{
+    bool found = false;
+    IntersectSorted(sorted_term_ids, document_to_term_ids_.at(document_id), [&found](int) { found = true; });
+    return found;
+}
+
+const PostingList* SearchServer::FindPostings(const std::string_view word) const
+{
+    if (!dictionary_.MayContain(word))
+    {
+        return nullptr;
+    }
+    const auto it = word_to_document_freqs_.find(word);
+    return it == word_to_document_freqs_.end() || it->second.empty() ? nullptr : &it->second;
+}
+
+bool SearchServer::IsDenseScoringCheaper(const QueryPlan& plan) const
+{
+    if (all_documents_id_.empty())
+    {
+        return false;
+    }
+    const size_t span = static_cast<size_t>(*all_documents_id_.rbegin() - *all_documents_id_.begin()) + 1;
+    return span <= all_documents_id_.size() * DENSE_SCORES_SPAN_PER_DOCUMENT
+        && span <= plan.plus_posting_count * DENSE_SCORES_SPAN_PER_POSTING;
+}
+
+double SearchServer::ComputeWordInverseDocumentFreq(const PostingList& postings) const
+{
+    return log(GetDocumentCount() * 1.0 / postings.size());
+}
+
+bool SearchServer::IsBoundBelow(double bound, double threshold)
 {
-    return log(GetDocumentCount() * 1.0 / word_to_document_freqs_.at(word).size());
-}
\ No newline at end of file
+    const double margin = 1e-9 * (1.0 + std::abs(bound) + std::abs(threshold));
+    return (threshold - margin) - (bound + margin) >= COMPARISON_ACCURACY;
+}
+
+std::vector<Document> SearchServer::SelectTopDocuments(std::vector<Document> documents, size_t count)
+{
+    const size_t top_count = std::min(count, documents.size());
+    std::partial_sort(documents.begin(), documents.begin() + top_count, documents.end(), IsRankedBefore);
+    documents.resize(top_count);
+    return documents;
+}
+
+bool SearchServer::IsRankedBefore(const Document& lhs, const Document& rhs)
+{
+    if (std::abs(lhs.relevance - rhs.relevance) < COMPARISON_ACCURACY)
+    {
+        if (lhs.rating != rhs.rating)
+        {
+            return lhs.rating > rhs.rating;
+        }
+        return lhs.id < rhs.id;
+    }
+    return lhs.relevance > rhs.relevance;
+}
@@ -1,33 +1,79 @@
 #pragma once
 #include "string_processing.h"
+#include "query_parser.h"
 #include "concurrent_map.h" 
 #include "document.h"
+#include "query_stage_times.h"
+#include "term_dictionary.h"
+#include "posting_list.h"
+#include "thread_pool.h"
+#include "query_budget.h"
+#include "query_planner.h"
+#include "memory_usage.h"
+#include "index_memory.h"
+#include "impact_index.h"
+#include "scoring_kernel.h"
+#include "document_text_store.h"
+#include "search_cursor.h"
 #include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <map>
+#include <memory_resource>
 #include <numeric>
 #include <set>
 #include <string>
 #include <vector>
 #include <execution>
+#include <functional>
+#include <limits>
 #include <string_view>
 #include <deque>
 #include <thread>
+#include <unordered_map>
+#include <optional>
+#include <future>
 
 constexpr int MAX_RESULT_DOCUMENT_COUNT = 5;
 constexpr double COMPARISON_ACCURACY = 1e-6;
 const unsigned int THREAD_COUNT = std::thread::hardware_concurrency();
 
+struct SearchServerOptions
+{
+    // Worker threads that run the execution::par requests of the server;
+    // with 0 they run on the calling thread
+    size_t thread_count = THREAD_COUNT;
+    // Bind every worker to its own CPU (Linux only)
+    bool pin_threads = false;
+    // Skip plus words found in (nearly) every document: their IDF is below COMPARISON_ACCURACY, so they
+    // can't change the order of documents, but a document matching only such words is not found
+    bool drop_zero_idf_terms = false;
+    // Memory resource of the index containers; see IndexAllocation
+    IndexAllocation allocation = IndexAllocation::GLOBAL_HEAP;
+    // Back an ARENA with 2 MiB pages (Linux only)
+    bool use_huge_pages = false;
+    // Accumulators of the dense term-at-a-time scoring; the sparse one always sums doubles
+    ScorePrecision score_precision = ScorePrecision::DOUBLE;
+    // Where GetDocumentText reads the texts from; the index never needs them
+    TextRetention text_retention = TextRetention::PLAIN;
+    // Directory of the file of TextRetention::MAPPED_FILE, the temporary directory of the system when empty.
+    // Every server creates a file with a unique name there and deletes it with itself
+    std::string text_file_directory;
+};
+
 class SearchServer
 {
 public:
     template <typename StringContainer>
-    explicit SearchServer(const StringContainer& stop_words);
+    explicit SearchServer(const StringContainer& stop_words, const SearchServerOptions& options = {});
 
-    explicit SearchServer(const std::string_view stop_words_text);
+    explicit SearchServer(const std::string_view stop_words_text, const SearchServerOptions& options = {});
 
-    explicit SearchServer(const std::string& stop_words_text);
+    explicit SearchServer(const std::string& stop_words_text, const SearchServerOptions& options = {});
+
+    SearchServer(const SearchServer&) = delete;
+
+    SearchServer& operator=(const SearchServer&) = delete;
 
     void AddDocument(int document_id, const std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
 
@@ -53,19 +99,133 @@ public:
     template<typename ExecutionPolicy>
     std::vector<Document> FindTopDocuments(const ExecutionPolicy& policy, const std::string_view raw_query) const;
 
+    // Search limited by QueryOptions: once the deadline passes, the posting budget runs out or the query
+    // is cancelled, scoring stops and the best documents found so far are returned flagged as partial
+    // string, [](document_id, status, rating) { return; }, options
+    template <typename DocumentFilter>
+    SearchResult FindTopDocumentsWithin(const std::string_view raw_query, DocumentFilter document_filter, const QueryOptions& options) const;
+
+    // string, status, options
+    SearchResult FindTopDocumentsWithin(const std::string_view raw_query, DocumentStatus document_status, const QueryOptions& options) const;
+
+    // string, options
+    SearchResult FindTopDocumentsWithin(const std::string_view raw_query, const QueryOptions& options) const;
+
+    // FindTopDocumentsWithin on the server thread pool; don't wait for the result from inside a pool task
+    // string, [](document_id, status, rating) { return; }, options
+    template <typename DocumentFilter>
+    std::future<SearchResult> FindTopDocumentsAsync(std::string raw_query, DocumentFilter document_filter, QueryOptions options) const;
+
+    // string, status, options
+    std::future<SearchResult> FindTopDocumentsAsync(std::string raw_query, DocumentStatus document_status, QueryOptions options = {}) const;
+
+    // string, options
+    std::future<SearchResult> FindTopDocumentsAsync(std::string raw_query, QueryOptions options = {}) const;
+
+    // Best documents found score-at-a-time in the impact index: the blocks of the highest impact over all
+    // the query words are read first, and the search stops as soon as no unread posting can change the best
+    // documents. Without the impact index it is FindTopDocuments. Relevances are summed in double whatever
+    // score_precision is, so results equal those of FindTopDocuments(execution::seq, ...) under
+    // ScorePrecision::DOUBLE only; under FLOAT they may differ as described there
+    // string, [](document_id, status, rating) { return; }
+    template <typename DocumentFilter>
+    std::vector<Document> FindTopDocumentsByImpact(const std::string_view raw_query, DocumentFilter document_filter) const;
+
+    // string, status
+    std::vector<Document> FindTopDocumentsByImpact(const std::string_view raw_query, DocumentStatus document_status) const;
+
+    // string
+    std::vector<Document> FindTopDocumentsByImpact(const std::string_view raw_query) const;
+
+    // Search-after pagination that keeps the scored documents: the query is scored once, the pages are
+    // taken from the cursor in the order of SearchCursor::IsPagedBefore, the first one after `after`
+    // execution::sep|par, string, [](document_id, status, rating) { return; }, cursor
+    template <typename DocumentFilter, typename ExecutionPolicy>
+    SearchCursor OpenSearchCursor(const ExecutionPolicy& policy, const std::string_view raw_query,
+        DocumentFilter document_filter, const std::optional<Document>& after = std::nullopt) const;
+
+    // execution::sep|par, string, status, cursor
+    template<typename ExecutionPolicy>
+    SearchCursor OpenSearchCursor(const ExecutionPolicy& policy, const std::string_view raw_query,
+        DocumentStatus document_status, const std::optional<Document>& after = std::nullopt) const;
+
+    // Stateless search-after pagination: the page of documents paged right after `after`, the last document
+    // of the previous page (std::nullopt for the first page). Every call scores the query again; a caller
+    // that can keep state between pages should use OpenSearchCursor
+    // execution::sep|par, string, [](document_id, status, rating) { return; }, cursor, int
+    template <typename DocumentFilter, typename ExecutionPolicy>
+    std::vector<Document> FindTopDocumentsAfter(const ExecutionPolicy& policy, const std::string_view raw_query,
+        DocumentFilter document_filter, const std::optional<Document>& after, size_t page_size) const;
+
+    // execution::sep|par, string, status, cursor, int
+    template<typename ExecutionPolicy>
+    std::vector<Document> FindTopDocumentsAfter(const ExecutionPolicy& policy, const std::string_view raw_query,
+        DocumentStatus document_status, const std::optional<Document>& after, size_t page_size) const;
+
+    // execution::sep, string, cursor, int
+    std::vector<Document> FindTopDocumentsAfter(const std::string_view raw_query, const std::optional<Document>& after, size_t page_size) const;
+
     template<typename ExecutionPolicy>
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const ExecutionPolicy& policy,
         const std::string_view raw_query, int document_id) const;
 
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::string_view raw_query, int document_id) const;
 
+    // Matches one query against many documents: the query is parsed once, documents are processed in parallel
+    // execution::sep|par, string, ids
+    template<typename ExecutionPolicy>
+    std::vector<std::tuple<std::vector<std::string_view>, DocumentStatus>> MatchDocuments(const ExecutionPolicy& policy,
+        const std::string_view raw_query, const std::vector<int>& document_ids) const;
+
+    std::vector<std::tuple<std::vector<std::string_view>, DocumentStatus>> MatchDocuments(
+        const std::string_view raw_query, const std::vector<int>& document_ids) const;
+
     int GetDocumentCount() const;
 
-    std::set<int>::iterator begin() const;
+    // Ids of the documents in ascending order
+    using DocumentIdIterator = std::pmr::set<int>::const_iterator;
+
+    // Words of a document with their term frequencies, sorted by word. Refers to the index,
+    // so it is valid until the document is removed; converts to a std::map copy
+    class WordFrequencies
+    {
+    public:
+        using const_iterator = std::pmr::map<std::string_view, double>::const_iterator;
+
+        const_iterator begin() const;
+
+        const_iterator end() const;
+
+        size_t size() const;
+
+        bool empty() const;
+
+        size_t count(const std::string_view word) const;
+
+        const_iterator find(const std::string_view word) const;
+
+        // out_of_range for a word not in the document
+        double at(const std::string_view word) const;
+
+        operator std::map<std::string_view, double>() const;
+
+    private:
+        friend class SearchServer;
+
+        explicit WordFrequencies(const std::pmr::map<std::string_view, double>& word_freqs);
 
-    std::set<int>::iterator end() const;
+        const std::pmr::map<std::string_view, double>* word_freqs_;
+    };
+
+    DocumentIdIterator begin() const;
+
+    DocumentIdIterator end() const;
 
-    const std::map<std::string_view, double>& GetWordFrequencies(int document_id) const;
+    WordFrequencies GetWordFrequencies(int document_id) const;
+
+    // Text as it was added; out_of_range for an unknown id, logic_error with TextRetention::NONE.
+    // Safe to call concurrently with queries and with itself
+    std::string GetDocumentText(int document_id) const;
 
     // execution::sep|par, int
     template<typename ExecutionPolicy>
@@ -74,51 +234,151 @@ public:
     // int
     void RemoveDocument(int document_id);
 
+    // Removes many documents at once: the postings of every word are edited once for all of them,
+    // different words in parallel for execution::par; ids of non-existent documents are skipped.
+    // Words left in no document are dropped, the views of them returned by MatchDocument become invalid
+    // execution::sep|par, ids
+    template<typename ExecutionPolicy>
+    void RemoveDocuments(ExecutionPolicy&& policy, const std::vector<int>& document_ids);
+
+    // ids
+    void RemoveDocuments(const std::vector<int>& document_ids);
+
+    // Builds the impact-ordered copy of the postings for FindTopDocumentsByImpact. Every added or removed
+    // document drops it, so it suits an index that is rebuilt in bulk and then only searched
+    void BuildImpactIndex();
+
+    bool HasImpactIndex() const;
+
+    // Pool behind the parallel requests, also available for work related to the server
+    ThreadPool& GetThreadPool() const;
+
+    // Filter that rejects unknown query words before the dictionary lookup
+    TermFilter::Stats GetTermFilterStats() const;
+
+    // Memory of the index by structure, kept up to date by AddDocument and RemoveDocument; O(1).
+    // Index containers in pools or an arena are reported as one total, see MemoryUsage::index_resource
+    MemoryUsage GetMemoryUsage() const;
+
+    // Ranking order of FindTopDocuments: by relevance, relevances closer than COMPARISON_ACCURACY tie and are
+    // ordered by rating, then by id. Ties are not transitive, so it is not a strict weak ordering
+    static bool IsRankedBefore(const Document& lhs, const Document& rhs);
+
+    // Best `count` documents, sorted; O(n * log(count)). Selected with heaps, which stay within
+    // the range whatever the comparison, unlike the unguarded loops of std::sort
+    static std::vector<Document> SelectTopDocuments(std::vector<Document> documents, size_t count);
+
 private:
     struct DocumentData
     {
         int rating;
         DocumentStatus status;
-        std::string document_view;
     };
 
-    std::set<std::string, std::less<>> stop_words_;
-    std::map<std::string_view, std::map<int, double>> word_to_document_freqs_;
-    std::map<int, std::map<std::string_view, double>> document_to_word_freqs_;
-    std::map<int, DocumentData> documents_;
-    std::set<int> all_documents_id_;
+    // Every per-document structure of the index, placed in the index memory resource
+    struct IndexContainers
+    {
+        explicit IndexContainers(std::pmr::memory_resource* resource);
+
+        std::pmr::map<std::string_view, PostingList> word_to_document_freqs;
+        std::pmr::map<int, std::pmr::map<std::string_view, double>> document_to_word_freqs;
+        std::pmr::map<int, std::pmr::vector<int>> document_to_term_ids;
+        std::pmr::map<int, DocumentData> documents;
+        std::pmr::set<int> all_documents_id;
+    };
+
+    // Skips the destructors when the resource frees all its memory by itself
+    struct IndexContainersDeleter
+    {
+        const IndexMemory* memory;
 
-    bool IsStopWord(const std::string_view word) const;
+        void operator()(IndexContainers* index) const;
+    };
 
-    static bool IsValidWord(const std::string_view word);
+    const SearchServerOptions options_;
+    StopWords stop_words_;
+    // Index keys refer to the words stored here rather than to the document text, so they outlive removed documents
+    TermDictionary dictionary_;
+    std::unique_ptr<IndexMemory> index_memory_;
+    std::unique_ptr<IndexContainers, IndexContainersDeleter> index_;
+    std::pmr::map<std::string_view, PostingList>& word_to_document_freqs_;
+    std::pmr::map<int, std::pmr::map<std::string_view, double>>& document_to_word_freqs_;
+    // Forward index: sorted ids of the document terms
+    std::pmr::map<int, std::pmr::vector<int>>& document_to_term_ids_;
+    std::pmr::map<int, DocumentData>& documents_;
+    std::pmr::set<int>& all_documents_id_;
+    // nullptr until BuildImpactIndex
+    std::unique_ptr<ImpactIndex> impact_index_;
+    std::unique_ptr<DocumentTextStore> text_store_;
+    // Everything but the dictionary, the impact index and the texts, which keep their own count
+    MemoryUsage memory_usage_;
+    // Declared last to be destroyed first: queued tasks may still use the index
+    std::unique_ptr<ThreadPool> thread_pool_;
 
     void IsValidDocument(int document_id, const std::string_view document) const;
 
     void IsValidId(int document_id) const;
 
-    std::vector<std::string_view> SplitIntoWordsNoStop(const std::string_view text) const;
+    static std::unique_ptr<IndexContainers, IndexContainersDeleter> CreateIndexContainers(const IndexMemory& memory);
 
-    static int ComputeAverageRating(const std::vector<int>& ratings);
+    // Forward index and metadata of one document; existence required
+    MemoryUsage GetDocumentMemoryUsage(int document_id) const;
 
-    struct QueryWord
-    {
-        std::string_view data;
-        bool is_minus;
-        bool is_stop;
-    };
+    // Erases the entries of all the sorted keys, each must be present
+    template <typename Container>
+    static void EraseSortedKeys(Container& container, const std::vector<int>& sorted_keys);
+
+    using Query = ParsedQuery;
 
-    QueryWord ParseQueryWord(std::string_view text) const;
+    Query ParseQuery(const std::string_view text) const;
 
-    struct Query
+    // Sorted ids of the known query words
+    struct QueryTerms
     {
-        std::vector<std::string_view> plus_words;
-        std::vector<std::string_view> minus_words;
+        std::vector<int> plus_terms;
+        std::vector<int> minus_terms;
     };
 
-    Query ParseQuery(const std::string_view text, bool flag = true) const;
+    QueryTerms ParseQueryTerms(const std::string_view text) const;
+
+    // Posting lists of the known query words in the order of evaluation
+    QueryPlan PlanQuery(const Query& query) const;
+
+    std::vector<int> FindTermIds(const std::vector<std::string_view>& words) const;
+
+    // Existence required
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchQueryTerms(const QueryTerms& query_terms, int document_id) const;
 
     // Existence required
-    double ComputeWordInverseDocumentFreq(const std::string_view word) const;
+    bool ContainsAnyTerm(int document_id, const std::vector<int>& sorted_term_ids) const;
+
+    // nullptr if the word is not indexed; unknown words are rejected by the dictionary filter
+    const PostingList* FindPostings(const std::string_view word) const;
+
+    double ComputeWordInverseDocumentFreq(const PostingList& postings) const;
+
+    // Whether every relevance up to `bound` ranks after every relevance from `threshold` whatever the ratings
+    // and ids are: they are at least COMPARISON_ACCURACY apart, with a margin for the rounding of the same
+    // sums taken in another order
+    static bool IsBoundBelow(double bound, double threshold);
+
+    // function(i) for every i in [0, count): in a loop for execution::seq, on the thread pool otherwise
+    template <typename ExecutionPolicy, typename Function>
+    void ForEachIndex(const ExecutionPolicy& policy, size_t count, Function function) const;
+
+    // An accumulator per id from the least to the greatest one beats both a map of the scored documents
+    // and a merge of the lists when the ids are dense and the query reads a fair share of the postings
+    static constexpr size_t DENSE_SCORES_SPAN_PER_DOCUMENT = 4;
+    static constexpr size_t DENSE_SCORES_SPAN_PER_POSTING = 16;
+    static constexpr size_t DOCUMENT_LOOKUP_COST = 3;
+
+    bool IsDenseScoringCheaper(const QueryPlan& plan) const;
+
+    // Term-at-a-time scoring into an array indexed by id; parts of the id range are scored in parallel,
+    // each sums the terms in plan order, so the relevances are the same with any policy
+    template <typename Score, typename ExecutionPolicy, typename DocumentFilter>
+    std::vector<Document> FindAllDocumentsDense(const ExecutionPolicy& policy, const QueryPlan& plan,
+        const std::vector<int>& excluded, DocumentFilter& document_filter) const;
 
     template <typename DocumentFilter>
     std::vector<Document> FindAllDocuments(const Query& query, DocumentFilter document_filter) const;
@@ -129,16 +389,22 @@ private:
 
 
 template <typename StringContainer>
-SearchServer::SearchServer(const StringContainer& stop_words)
-    : stop_words_(MakeUniqueNonEmptyStrings(stop_words))
+SearchServer::SearchServer(const StringContainer& stop_words, const SearchServerOptions& options)
+    : options_(options)
+    , stop_words_(MakeStopWords(stop_words))
+    , index_memory_(std::make_unique<IndexMemory>(options.allocation, options.use_huge_pages))
+    , index_(CreateIndexContainers(*index_memory_))
+    , word_to_document_freqs_(index_->word_to_document_freqs)
+    , document_to_word_freqs_(index_->document_to_word_freqs)
+    , document_to_term_ids_(index_->document_to_term_ids)
+    , documents_(index_->documents)
+    , all_documents_id_(index_->all_documents_id)
+    , text_store_(std::make_unique<DocumentTextStore>(options.text_retention, options.text_file_directory))
+    , thread_pool_(std::make_unique<ThreadPool>(options.thread_count, options.pin_threads))
 {
     for (const std::string& stop_word : stop_words_)
     {
-        if (!IsValidWord(stop_word))
-        {
-            using namespace std::string_literals;
-            throw std::invalid_argument("Stop word contains invalid characters"s);
-        }
+        memory_usage_.stop_words += GetTreeNodeBytes<std::string>() + GetStringHeapBytes(stop_word);
     }
 }
 
@@ -153,21 +419,22 @@ std::vector<Document> SearchServer::FindTopDocuments(const std::string_view raw_
 template <typename DocumentFilter, typename ExecutionPolicy>
 std::vector<Document> SearchServer::FindTopDocuments(const ExecutionPolicy& policy, const std::string_view raw_query, DocumentFilter document_filter) const
 {
-    const Query query = ParseQuery(raw_query);
-    auto matched_documents = FindAllDocuments(policy, query, document_filter);
-    sort(policy, matched_documents.begin(), matched_documents.end(), [](const Document& lhs, const Document& rhs)
+    if (current_query_stage_times)
     {
-        if (std::abs(lhs.relevance - rhs.relevance) < COMPARISON_ACCURACY)
-        {
-            return lhs.rating > rhs.rating;
-        }
-        return lhs.relevance > rhs.relevance;
-    });
-    if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT)
+        ++current_query_stage_times->queries;
+    }
+    Query query;
     {
-        matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+        QueryStageTimer timer(&QueryStageTimes::parse);
+        query = ParseQuery(raw_query);
     }
-    return matched_documents;
+    std::vector<Document> matched_documents;
+    {
+        QueryStageTimer timer(&QueryStageTimes::score);
+        matched_documents = FindAllDocuments(policy, query, document_filter);
+    }
+    QueryStageTimer timer(&QueryStageTimes::rank);
+    return SelectTopDocuments(std::move(matched_documents), MAX_RESULT_DOCUMENT_COUNT);
 }
 
 // execution::sep|par, string, status
@@ -186,112 +453,581 @@ std::vector<Document> SearchServer::FindTopDocuments(const ExecutionPolicy& poli
     return FindTopDocuments(policy, raw_query, DocumentStatus::ACTUAL);
 }
 
+// string, [](document_id, status, rating) { return; }, options
+template <typename DocumentFilter>
+SearchResult SearchServer::FindTopDocumentsWithin(const std::string_view raw_query, DocumentFilter document_filter, const QueryOptions& options) const
+{
+    QueryBudget budget(options);
+    SearchResult result;
+    budget.Charge(0);
+    if (budget.IsExhausted())
+    {
+        result.is_partial = true;
+        return result;
+    }
+    const Query query = ParseQuery(raw_query);
 
-template<typename ExecutionPolicy>
-std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(const ExecutionPolicy& policy,
-    const std::string_view raw_query, int document_id) const
+    // Rarest words first: they cost the least and weigh the most, so a query cut short keeps the best part of the score
+    const QueryPlan plan = PlanQuery(query);
+
+    std::map<int, double> document_to_relevance;
+    PostingList::DecodedBlock block;
+    for (const auto& [postings, inverse_document_freq] : plan.plus_terms)
+    {
+        for (size_t block_index = 0; block_index < postings->GetBlockCount(); ++block_index)
+        {
+            // The last block within the budget is scored in part
+            const size_t scored_count = budget.Charge(postings->GetBlockSize(block_index));
+            if (scored_count == 0)
+            {
+                break;
+            }
+            postings->DecodeBlock(block_index, block);
+            for (size_t i = 0; i < scored_count; ++i)
+            {
+                const DocumentData& document_at = documents_.at(block.document_ids[i]);
+                if (document_filter(block.document_ids[i], document_at.status, document_at.rating))
+                {
+                    document_to_relevance[block.document_ids[i]] += block.term_freqs[i] * inverse_document_freq;
+                }
+            }
+        }
+        if (budget.IsExhausted())
+        {
+            break;
+        }
+    }
+
+    // Minus words are checked in the forward index of the candidates, so they hold for a partial result too
+    const std::vector<int> minus_terms = FindTermIds(query.minus_words);
+    std::vector<Document> matched_documents;
+    for (const auto [document_id, relevance] : document_to_relevance)
+    {
+        if (!ContainsAnyTerm(document_id, minus_terms))
+        {
+            matched_documents.push_back({ document_id, relevance, documents_.at(document_id).rating });
+        }
+    }
+    result.documents = SelectTopDocuments(std::move(matched_documents), MAX_RESULT_DOCUMENT_COUNT);
+    result.is_partial = budget.IsExhausted();
+    result.scored_postings = budget.GetChargedPostings();
+    return result;
+}
+
+// string, [](document_id, status, rating) { return; }
+template <typename DocumentFilter>
+std::vector<Document> SearchServer::FindTopDocumentsByImpact(const std::string_view raw_query, DocumentFilter document_filter) const
 {
-    if constexpr (std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::sequenced_policy>)
+    const Query query = ParseQuery(raw_query);
+    const QueryPlan plan = PlanQuery(query);
+
+    // Unread postings of a word add at most remaining_bound to a document
+    struct TermCursor
     {
-        return MatchDocument(raw_query, document_id);
+        const ImpactList* list;
+        double inverse_document_freq;
+        size_t block_index = 0;
+        double remaining_bound = 0.0;
+    };
+    std::vector<TermCursor> cursors;
+    for (const PlannedTerm& term : plan.plus_terms)
+    {
+        const ImpactList* list = impact_index_ ? impact_index_->Find(*term.postings) : nullptr;
+        if (list == nullptr)
+        {
+            break;
+        }
+        cursors.push_back({ list, term.inverse_document_freq, 0, list->GetBlockBound(0) * term.inverse_document_freq });
+    }
+    // Candidates keep the words they were seen with in a 64-bit mask
+    if (cursors.size() < plan.plus_terms.size() || cursors.size() > 64)
+    {
+        return SelectTopDocuments(FindAllDocuments(query, document_filter), MAX_RESULT_DOCUMENT_COUNT);
     }
-    IsValidId(document_id);
-    const Query query = ParseQuery(raw_query, false);
-    std::vector<std::string_view> matched_words(query.plus_words.size());
 
-    bool is_minus = std::any_of(std::execution::par, query.minus_words.begin(), query.minus_words.end(),
-        [this, document_id](const std::string_view word)
+    struct Candidate
     {
-        return (word_to_document_freqs_.count(word) > 0) &&
-            (word_to_document_freqs_.at(word).count(document_id) > 0);
-    });
-    if (is_minus)
+        double partial_relevance = 0.0;
+        uint64_t seen_terms = 0;
+        bool is_wanted = false;
+    };
+    const std::vector<int> excluded = CollectDocumentIds(plan.minus_postings);
+    std::unordered_map<int, Candidate> candidates;
+
+    // Relevance summed in the plan order from the forward index, bit for bit that of FindTopDocuments
+    auto compute_relevance = [&](int document_id)
+    {
+        const std::pmr::map<std::string_view, double>& word_freqs = document_to_word_freqs_.at(document_id);
+        double relevance = 0.0;
+        for (const TermCursor& cursor : cursors)
+        {
+            const auto word_freq = word_freqs.find(cursor.list->GetWord());
+            if (word_freq != word_freqs.end())
+            {
+                relevance += word_freq->second * cursor.inverse_document_freq;
+            }
+        }
+        return relevance;
+    };
+
+    // Settled when no unseen document can reach the MAX_RESULT_DOCUMENT_COUNT-th relevance of the candidates:
+    // the best documents are then among the candidates whose bound reaches it, the contenders
+    std::vector<int> contenders;
+    auto is_settled = [&]()
+    {
+        std::vector<std::pair<double, int>> partial_relevances;
+        for (const auto& [document_id, candidate] : candidates)
+        {
+            if (candidate.is_wanted)
+            {
+                partial_relevances.emplace_back(candidate.partial_relevance, document_id);
+            }
+        }
+        if (partial_relevances.size() < MAX_RESULT_DOCUMENT_COUNT)
+        {
+            return false;
+        }
+        // The best partial relevances are completed from the forward index for a tighter threshold
+        std::nth_element(partial_relevances.begin(), partial_relevances.begin() + (MAX_RESULT_DOCUMENT_COUNT - 1),
+            partial_relevances.end(), std::greater<std::pair<double, int>>());
+        double threshold = std::numeric_limits<double>::max();
+        for (size_t i = 0; i < MAX_RESULT_DOCUMENT_COUNT; ++i)
+        {
+            threshold = std::min(threshold, compute_relevance(partial_relevances[i].second));
+        }
+        double unseen_bound = 0.0;
+        for (const TermCursor& cursor : cursors)
+        {
+            unseen_bound += cursor.remaining_bound;
+        }
+        if (!IsBoundBelow(unseen_bound, threshold))
+        {
+            return false;
+        }
+
+        for (const auto& [document_id, candidate] : candidates)
+        {
+            double bound = candidate.partial_relevance;
+            for (size_t i = 0; i < cursors.size(); ++i)
+            {
+                if (!(candidate.seen_terms >> i & 1))
+                {
+                    bound += cursors[i].remaining_bound;
+                }
+            }
+            if (candidate.is_wanted && !IsBoundBelow(bound, threshold))
+            {
+                contenders.push_back(document_id);
+            }
+        }
+        return true;
+    };
+
+    size_t postings_since_check = 0;
+    bool settled = false;
+    while (!settled)
     {
-        return { std::vector<std::string_view> {}, documents_.at(document_id).status };
+        // Block of the highest bound over all the words
+        size_t term_index = cursors.size();
+        for (size_t i = 0; i < cursors.size(); ++i)
+        {
+            if (cursors[i].block_index < cursors[i].list->GetBlockCount()
+                && (term_index == cursors.size() || cursors[i].remaining_bound > cursors[term_index].remaining_bound))
+            {
+                term_index = i;
+            }
+        }
+        if (term_index == cursors.size())
+        {
+            break;
+        }
+
+        TermCursor& cursor = cursors[term_index];
+        const uint64_t term_bit = uint64_t{ 1 } << term_index;
+        cursor.list->ForEachInBlock(cursor.block_index, [&](int document_id, double term_freq)
+        {
+            auto it = candidates.find(document_id);
+            if (it == candidates.end())
+            {
+                const DocumentData& document_at = documents_.at(document_id);
+                Candidate candidate;
+                candidate.is_wanted = document_filter(document_id, document_at.status, document_at.rating)
+                    && !std::binary_search(excluded.begin(), excluded.end(), document_id);
+                it = candidates.emplace(document_id, candidate).first;
+            }
+            if (it->second.is_wanted)
+            {
+                it->second.partial_relevance += term_freq * cursor.inverse_document_freq;
+                it->second.seen_terms |= term_bit;
+            }
+        });
+        postings_since_check += cursor.list->GetBlockSize(cursor.block_index);
+        ++cursor.block_index;
+        cursor.remaining_bound = cursor.block_index < cursor.list->GetBlockCount()
+            ? cursor.list->GetBlockBound(cursor.block_index) * cursor.inverse_document_freq : 0.0;
+
+        // A check costs a pass over the candidates, it is paid for by at least as many postings
+        if (postings_since_check >= candidates.size())
+        {
+            postings_since_check = 0;
+            settled = is_settled();
+        }
+    }
+    // With every list read the bounds are the partial relevances themselves
+    if (!settled && !is_settled())
+    {
+        for (const auto& [document_id, candidate] : candidates)
+        {
+            if (candidate.is_wanted)
+            {
+                contenders.push_back(document_id);
+            }
+        }
     }
 
-    auto new_end = std::copy_if(std::execution::par, query.plus_words.begin(), query.plus_words.end(), matched_words.begin(),
-        [this, document_id](const std::string_view word)
+    std::vector<Document> matched_documents;
+    matched_documents.reserve(contenders.size());
+    for (const int document_id : contenders)
     {
-        return (word_to_document_freqs_.count(word) > 0) &&
-            (word_to_document_freqs_.at(word).count(document_id) > 0);;
-    });
+        matched_documents.push_back({ document_id, compute_relevance(document_id), documents_.at(document_id).rating });
+    }
+    return SelectTopDocuments(std::move(matched_documents), MAX_RESULT_DOCUMENT_COUNT);
+}
+
+// string, [](document_id, status, rating) { return; }, options
+template <typename DocumentFilter>
+std::future<SearchResult> SearchServer::FindTopDocumentsAsync(std::string raw_query, DocumentFilter document_filter, QueryOptions options) const
+{
+    return thread_pool_->Async(
+        [this, raw_query = std::move(raw_query), document_filter, options = std::move(options)]()
+        {
+            return FindTopDocumentsWithin(raw_query, document_filter, options);
+        });
+}
 
-    std::sort(matched_words.begin(), new_end);
-    new_end = std::unique(matched_words.begin(), new_end);
-    matched_words.erase(new_end, matched_words.end());
-    return { matched_words, documents_.at(document_id).status };
+// execution::sep|par, string, [](document_id, status, rating) { return; }, cursor
+template <typename DocumentFilter, typename ExecutionPolicy>
+SearchCursor SearchServer::OpenSearchCursor(const ExecutionPolicy& policy, const std::string_view raw_query,
+    DocumentFilter document_filter, const std::optional<Document>& after) const
+{
+    const Query query = ParseQuery(raw_query);
+    return SearchCursor(FindAllDocuments(policy, query, document_filter), after);
+}
+
+// execution::sep|par, string, status, cursor
+template<typename ExecutionPolicy>
+SearchCursor SearchServer::OpenSearchCursor(const ExecutionPolicy& policy, const std::string_view raw_query,
+    DocumentStatus document_status, const std::optional<Document>& after) const
+{
+    return OpenSearchCursor(policy, raw_query,
+        [document_status](int document_id, DocumentStatus status, int rating)
+            { return status == document_status; },
+        after);
+}
+
+// execution::sep|par, string, [](document_id, status, rating) { return; }, cursor, int
+template <typename DocumentFilter, typename ExecutionPolicy>
+std::vector<Document> SearchServer::FindTopDocumentsAfter(const ExecutionPolicy& policy, const std::string_view raw_query,
+    DocumentFilter document_filter, const std::optional<Document>& after, size_t page_size) const
+{
+    return OpenSearchCursor(policy, raw_query, document_filter, after).NextPage(page_size);
+}
+
+// execution::sep|par, string, status, cursor, int
+template<typename ExecutionPolicy>
+std::vector<Document> SearchServer::FindTopDocumentsAfter(const ExecutionPolicy& policy, const std::string_view raw_query,
+    DocumentStatus document_status, const std::optional<Document>& after, size_t page_size) const
+{
+    return FindTopDocumentsAfter(policy, raw_query,
+        [document_status](int document_id, DocumentStatus status, int rating)
+            { return status == document_status; },
+        after, page_size);
+}
+
+template<typename ExecutionPolicy>
+std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(const ExecutionPolicy& policy,
+    const std::string_view raw_query, int document_id) const
+{
+    // A single document is matched by a merge of two short sorted arrays, too little work to share between threads
+    return MatchDocument(raw_query, document_id);
+}
+
+// execution::sep|par, string, ids
+template<typename ExecutionPolicy>
+std::vector<std::tuple<std::vector<std::string_view>, DocumentStatus>> SearchServer::MatchDocuments(const ExecutionPolicy& policy,
+    const std::string_view raw_query, const std::vector<int>& document_ids) const
+{
+    for (const int document_id : document_ids)
+    {
+        IsValidId(document_id);
+    }
+    const QueryTerms query_terms = ParseQueryTerms(raw_query);
+    std::vector<std::tuple<std::vector<std::string_view>, DocumentStatus>> matches(document_ids.size());
+    ForEachIndex(policy, document_ids.size(),
+        [this, &query_terms, &document_ids, &matches](size_t i)
+        {
+            matches[i] = MatchQueryTerms(query_terms, document_ids[i]);
+        });
+    return matches;
 }
 
 // execution::sep|par, int
 template<typename ExecutionPolicy>
 void SearchServer::RemoveDocument(ExecutionPolicy&& policy, int document_id)
 {
-    if (document_to_word_freqs_.count(document_id) == 0)
+    RemoveDocuments(policy, std::vector<int>{ document_id });
+}
+
+// execution::sep|par, ids
+template<typename ExecutionPolicy>
+void SearchServer::RemoveDocuments(ExecutionPolicy&& policy, const std::vector<int>& document_ids)
+{
+    std::vector<int> removed_ids;
+    removed_ids.reserve(document_ids.size());
+    for (const int document_id : document_ids)
+    {
+        if (documents_.count(document_id))
+        {
+            removed_ids.push_back(document_id);
+        }
+    }
+    std::sort(removed_ids.begin(), removed_ids.end());
+    removed_ids.erase(std::unique(removed_ids.begin(), removed_ids.end()), removed_ids.end());
+    if (removed_ids.empty())
     {
         return;
     }
+    impact_index_.reset();
+
+    // (term id, document id) of every posting to erase; sorted, the postings of one term are adjacent
+    std::vector<std::pair<int, int>> postings;
+    for (const int document_id : removed_ids)
+    {
+        for (const int term_id : document_to_term_ids_.at(document_id))
+        {
+            postings.emplace_back(term_id, document_id);
+        }
+        memory_usage_ -= GetDocumentMemoryUsage(document_id);
+    }
+    std::sort(postings.begin(), postings.end());
 
-    size_t words_size = document_to_word_freqs_.at(document_id).size();
-    std::vector<std::string_view> words_pointers(words_size);
+    // The posting lists are looked up before the parallel part, so the tasks never touch the outer map
+    std::vector<int> posting_document_ids(postings.size());
+    std::vector<int> term_ids;
+    std::vector<PostingList*> term_postings;
+    std::vector<size_t> term_ends;
+    for (size_t i = 0; i < postings.size(); ++i)
+    {
+        posting_document_ids[i] = postings[i].second;
+        if (i + 1 == postings.size() || postings[i + 1].first != postings[i].first)
+        {
+            term_ids.push_back(postings[i].first);
+            term_postings.push_back(&word_to_document_freqs_.at(dictionary_.GetTerm(postings[i].first)));
+            term_ends.push_back(i + 1);
+        }
+    }
 
-    std::transform(
-        policy,
-        document_to_word_freqs_.at(document_id).begin(), document_to_word_freqs_.at(document_id).end(),
-        words_pointers.begin(),
-        [](auto& document_freqs)
+    // Each task edits its own posting list
+    std::vector<size_t> freed_posting_bytes(term_postings.size());
+    ForEachIndex(policy, term_postings.size(),
+        [&term_postings, &term_ends, &posting_document_ids, &freed_posting_bytes](size_t i)
         {
-            return document_freqs.first;
+            const auto ids_begin = posting_document_ids.cbegin() + (i == 0 ? 0 : term_ends[i - 1]);
+            PostingList& term_list = *term_postings[i];
+            freed_posting_bytes[i] = term_list.GetMemoryBytes();
+            term_list.Erase(ids_begin, posting_document_ids.cbegin() + term_ends[i]);
+            freed_posting_bytes[i] -= term_list.GetMemoryBytes();
         });
+    // The differences may wrap around, their sum is still exact
+    memory_usage_.postings -= std::accumulate(freed_posting_bytes.begin(), freed_posting_bytes.end(), size_t{ 0 });
 
-    std::for_each(
-        policy,
-        words_pointers.begin(), words_pointers.end(),
-        [document_id, this](const std::string_view word)
+    // Words no document contains any more leave the index and the dictionary
+    for (size_t i = 0; i < term_postings.size(); ++i)
+    {
+        if (term_postings[i]->empty())
         {
-            word_to_document_freqs_.at(word).erase(document_id);
-        });
+            memory_usage_.postings -= term_postings[i]->GetMemoryBytes() + GetTreeNodeBytes<std::pair<const std::string_view, PostingList>>();
+            word_to_document_freqs_.erase(dictionary_.GetTerm(term_ids[i]));
+            dictionary_.RemoveTerm(term_ids[i]);
+        }
+    }
 
-    document_to_word_freqs_.erase(document_id);
-    documents_.erase(document_id);
-    all_documents_id_.erase(document_id);
+    EraseSortedKeys(document_to_word_freqs_, removed_ids);
+    EraseSortedKeys(document_to_term_ids_, removed_ids);
+    EraseSortedKeys(documents_, removed_ids);
+    EraseSortedKeys(all_documents_id_, removed_ids);
+    for (const int document_id : removed_ids)
+    {
+        text_store_->Remove(document_id);
+    }
 }
 
+template <typename Container>
+void SearchServer::EraseSortedKeys(Container& container, const std::vector<int>& sorted_keys)
+{
+    // Ids removed together are often adjacent: the entry after the last erased one is tried before a lookup
+    auto key_of = [](const typename Container::value_type& entry)
+    {
+        if constexpr (std::is_same_v<typename Container::value_type, int>)
+        {
+            return entry;
+        }
+        else
+        {
+            return entry.first;
+        }
+    };
+    auto position = container.begin();
+    for (const int key : sorted_keys)
+    {
+        if (position == container.end() || key_of(*position) != key)
+        {
+            position = container.find(key);
+        }
+        position = container.erase(position);
+    }
+}
 
-template <typename DocumentFilter>
-std::vector<Document> SearchServer::FindAllDocuments(const Query& query, DocumentFilter document_filter) const
+template <typename ExecutionPolicy, typename Function>
+void SearchServer::ForEachIndex(const ExecutionPolicy& policy, size_t count, Function function) const
 {
-    std::map<int, double> document_to_relevance;
-    for (const std::string_view word : query.plus_words)
+    if constexpr (std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::sequenced_policy>)
     {
-        if (word_to_document_freqs_.count(word) == 0)
+        for (size_t i = 0; i < count; ++i)
         {
-            continue;
+            function(i);
         }
-        const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-        for (const auto [document_id, term_freq] : word_to_document_freqs_.at(word))
+    }
+    else
+    {
+        thread_pool_->ParallelFor(0, count, function);
+    }
+}
+
+template <typename Score, typename ExecutionPolicy, typename DocumentFilter>
+std::vector<Document> SearchServer::FindAllDocumentsDense(const ExecutionPolicy& policy, const QueryPlan& plan,
+    const std::vector<int>& excluded, DocumentFilter& document_filter) const
+{
+    const int first_id = *all_documents_id_.begin();
+    const size_t span = static_cast<size_t>(*all_documents_id_.rbegin() - first_id) + 1;
+    std::vector<Score> scores(span, Score{ 0 });
+
+    const size_t part_count = std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::sequenced_policy>
+        ? 1 : std::min(span / PostingList::BLOCK_SIZE + 1, 4 * thread_pool_->GetThreadCount() + 1);
+    ForEachIndex(policy, part_count, [&](size_t part)
+    {
+        const int part_begin = first_id + static_cast<int>(span * part / part_count);
+        const int part_end = first_id + static_cast<int>(span * (part + 1) / part_count);
+        PostingList::DecodedBlock block;
+        for (const PlannedTerm& term : plan.plus_terms)
         {
-            DocumentData document_at = documents_.at(document_id);
-            if (document_filter(document_id, document_at.status, document_at.rating))
+            const PostingList& postings = *term.postings;
+            for (size_t block_index = postings.LowerBoundBlock(part_begin);
+                block_index < postings.GetBlockCount() && postings.GetBlockFirstDocumentId(block_index) < part_end; ++block_index)
             {
-                document_to_relevance[document_id] += term_freq * inverse_document_freq;
+                postings.DecodeBlock(block_index, block);
+                const size_t begin = std::lower_bound(block.document_ids, block.document_ids + block.size, part_begin) - block.document_ids;
+                const size_t end = std::lower_bound(block.document_ids + begin, block.document_ids + block.size, part_end) - block.document_ids;
+                AccumulateScores(block.document_ids + begin, block.term_freqs + begin, end - begin, first_id,
+                    static_cast<Score>(term.inverse_document_freq), scores.data());
             }
         }
-    }
+    });
 
-    for (const std::string_view word : query.minus_words)
+    // Every term weighs more than zero unless it is in every document
+    const bool matches_all = std::any_of(plan.plus_terms.begin(), plan.plus_terms.end(),
+        [](const PlannedTerm& term) { return term.inverse_document_freq == 0.0; });
+    size_t candidate_count = documents_.size();
+    if (!matches_all)
     {
-        if (word_to_document_freqs_.count(word) == 0)
+        candidate_count = static_cast<size_t>(std::count_if(scores.begin(), scores.end(), [](Score score) { return score != Score{ 0 }; }));
+    }
+    std::vector<Document> matched_documents;
+    auto excluded_position = excluded.begin();
+    auto add_document = [&](int document_id, const DocumentData& document_at)
+    {
+        excluded_position = std::lower_bound(excluded_position, excluded.end(), document_id);
+        if (excluded_position != excluded.end() && *excluded_position == document_id)
+        {
+            return;
+        }
+        if (document_filter(document_id, document_at.status, document_at.rating))
         {
-            continue;
+            matched_documents.push_back({ document_id, static_cast<double>(scores[document_id - first_id]), document_at.rating });
         }
-        for (const auto [document_id, _] : word_to_document_freqs_.at(word))
+    };
+    // A walk over all the documents in the order of ids visits a node per document, a lookup about
+    // DOCUMENT_LOOKUP_COST of them: the walk is cheaper when most of the documents are candidates
+    if (candidate_count * DOCUMENT_LOOKUP_COST >= documents_.size())
+    {
+        for (const auto& [document_id, document_at] : documents_)
         {
-            document_to_relevance.erase(document_id);
+            if (matches_all || scores[document_id - first_id] != Score{ 0 })
+            {
+                add_document(document_id, document_at);
+            }
         }
     }
+    else
+    {
+        for (size_t slot = 0; slot < span; ++slot)
+        {
+            if (scores[slot] != Score{ 0 })
+            {
+                const int document_id = first_id + static_cast<int>(slot);
+                add_document(document_id, documents_.at(document_id));
+            }
+        }
+    }
+    return matched_documents;
+}
 
+template <typename DocumentFilter>
+std::vector<Document> SearchServer::FindAllDocuments(const Query& query, DocumentFilter document_filter) const
+{
+    const QueryPlan plan = PlanQuery(query);
+    // Minus words go first: excluded documents are never scored or filtered
+    const std::vector<int> excluded = CollectDocumentIds(plan.minus_postings);
+    if (IsDenseScoringCheaper(plan))
+    {
+        return options_.score_precision == ScorePrecision::FLOAT
+            ? FindAllDocumentsDense<float>(std::execution::seq, plan, excluded, document_filter)
+            : FindAllDocumentsDense<double>(std::execution::seq, plan, excluded, document_filter);
+    }
     std::vector<Document> matched_documents;
+    if (plan.strategy == ScoringStrategy::DOCUMENT_AT_A_TIME)
+    {
+        ScoreDocumentAtATime(plan.plus_terms, excluded, [&](int document_id, double relevance)
+        {
+            const DocumentData& document_at = documents_.at(document_id);
+            if (document_filter(document_id, document_at.status, document_at.rating))
+            {
+                matched_documents.push_back({ document_id, relevance, document_at.rating });
+            }
+        });
+        return matched_documents;
+    }
+
+    std::map<int, double> document_to_relevance;
+    for (const PlannedTerm& term : plan.plus_terms)
+    {
+        // Both lists are sorted by id, the exclusion set is walked along with the postings
+        auto excluded_position = excluded.begin();
+        term.postings->ForEach([&](int document_id, double term_freq)
+        {
+            excluded_position = std::lower_bound(excluded_position, excluded.end(), document_id);
+            if (excluded_position != excluded.end() && *excluded_position == document_id)
+            {
+                return;
+            }
+            const DocumentData& document_at = documents_.at(document_id);
+            if (document_filter(document_id, document_at.status, document_at.rating))
+            {
+                document_to_relevance[document_id] += term_freq * term.inverse_document_freq;
+            }
+        });
+    }
+
     for (const auto [document_id, relevance] : document_to_relevance)
     {
         matched_documents.push_back({ document_id, relevance, documents_.at(document_id).rating });
@@ -307,42 +1043,33 @@ std::vector<Document> SearchServer::FindAllDocuments(const ExecutionPolicy& poli
     {
         return FindAllDocuments(query, document_filter);
     }
-    ConcurrentMap<int, double> document_to_relevance(THREAD_COUNT);
+    const QueryPlan plan = PlanQuery(query);
+    const std::vector<int> excluded = CollectDocumentIds(plan.minus_postings);
+    if (IsDenseScoringCheaper(plan))
     {
-        for_each(
-            std::execution::par,
-            query.plus_words.begin(), query.plus_words.end(),
-            [&, document_filter](const auto& word)
+        return options_.score_precision == ScorePrecision::FLOAT
+            ? FindAllDocumentsDense<float>(policy, plan, excluded, document_filter)
+            : FindAllDocumentsDense<double>(policy, plan, excluded, document_filter);
+    }
+    ConcurrentMap<int, double> document_to_relevance(thread_pool_->GetThreadCount() + 1);
+    // The longest lists are taken first, the short ones fill the gaps at the end
+    ForEachIndex(policy, plan.plus_terms.size(),
+        [&, document_filter](size_t i)
+        {
+            const PlannedTerm& term = plan.plus_terms[plan.plus_terms.size() - 1 - i];
+            term.postings->ForEach([&](int document_id, double term_freq)
             {
-                if (word_to_document_freqs_.count(word) > 0)
+                if (std::binary_search(excluded.begin(), excluded.end(), document_id))
                 {
-                    const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-                    for (const auto [document_id, term_freq] : word_to_document_freqs_.at(word))
-                    {
-                        DocumentData document_at = documents_.at(document_id);
-                        if (document_filter(document_id, document_at.status, document_at.rating))
-                        {
-                            document_to_relevance[document_id].ref_to_value += term_freq * inverse_document_freq;
-                        }
-                    }
+                    return;
                 }
-            });
-    }
-    {
-        for_each(
-            std::execution::par,
-            query.minus_words.begin(), query.minus_words.end(),
-            [&](auto word) 
-            {
-                if (word_to_document_freqs_.count(word) > 0) 
+                const DocumentData& document_at = documents_.at(document_id);
+                if (document_filter(document_id, document_at.status, document_at.rating))
                 {
-                    for (const auto [document_id, _] : word_to_document_freqs_.at(word))
-                    {
-                        document_to_relevance.Erase(document_id);
-                    }
+                    document_to_relevance[document_id].ref_to_value += term_freq * term.inverse_document_freq;
                 }
             });
-    }
+        });
     {
         std::vector<Document> matched_documents;
         for (const auto [document_id, relevance] : document_to_relevance.BuildOrdinaryMap()) 
@@ -0,0 +1,314 @@
+#include "segmented_index.h"
+
+SegmentedIndex::SegmentedIndex(const std::string_view stop_words_text, const SegmentedIndexOptions& options)
+    : SegmentedIndex(SplitIntoWords(stop_words_text), options)
+{
+}
+
+SegmentedIndex::SegmentedIndex(const std::string& stop_words_text, const SegmentedIndexOptions& options)
+    : SegmentedIndex(SplitIntoWords(std::string_view(stop_words_text)), options)
+{
+}
+
+void SegmentedIndex::AddDocument(int document_id, const std::string_view document, DocumentStatus status, const std::vector<int>& ratings)
+{
+    using namespace std::string_literals;
+    if (!IsValidWord(document))
+    {
+        throw std::invalid_argument("Document contains invalid characters"s);
+    }
+    if (document_id < 0)
+    {
+        throw std::invalid_argument("Attempt to add a document with a negative id"s);
+    }
+
+    // The document is prepared before the lock is taken, so that writers hold it only for the insertion
+    std::vector<std::string_view> words = SplitIntoWordsNoStop(document, stop_words_);
+    const uint32_t document_length = static_cast<uint32_t>(words.size());
+    std::sort(words.begin(), words.end());
+    std::vector<std::pair<std::string_view, uint32_t>> word_counts;
+    for (auto run_begin = words.begin(); run_begin != words.end();)
+    {
+        const auto run_end = std::upper_bound(run_begin, words.end(), *run_begin);
+        word_counts.emplace_back(*run_begin, static_cast<uint32_t>(run_end - run_begin));
+        run_begin = run_end;
+    }
+    const int rating = ComputeAverageRating(ratings);
+
+    bool start_merge = false;
+    {
+        std::unique_lock lock(mutex_);
+        if (FindLiveDocument(document_id).first != nullptr)
+        {
+            throw std::invalid_argument("Attempt to add a document with the id of a previously added document"s);
+        }
+        active_->AddDocument(document_id, status, rating, word_counts, document_length);
+        if (active_->GetDocumentCount() == options_.segment_size)
+        {
+            SealActiveSegment();
+            start_merge = ScheduleMerge();
+        }
+    }
+    if (start_merge)
+    {
+        StartMerge();
+    }
+}
+
+void SegmentedIndex::RemoveDocument(int document_id)
+{
+    bool start_merge = false;
+    {
+        std::unique_lock lock(mutex_);
+        const auto [segment, ordinal] = FindLiveDocument(document_id);
+        if (segment == nullptr)
+        {
+            return;
+        }
+        segment->Delete(ordinal);
+        const bool is_merging = std::any_of(merging_.begin(), merging_.end(),
+            [segment = segment](const SegmentPtr& source) { return source.get() == segment; });
+        if (is_merging)
+        {
+            merge_deletions_.emplace_back(segment, ordinal);
+        }
+        start_merge = segment != active_.get() && ScheduleMerge();
+    }
+    if (start_merge)
+    {
+        StartMerge();
+    }
+}
+
+// execution::sep, string, status
+std::vector<Document> SegmentedIndex::FindTopDocuments(const std::string_view raw_query, DocumentStatus document_status) const
+{
+    return FindTopDocuments(std::execution::seq, raw_query, document_status);
+}
+
+// execution::sep, string
+std::vector<Document> SegmentedIndex::FindTopDocuments(const std::string_view raw_query) const
+{
+    return FindTopDocuments(std::execution::seq, raw_query, DocumentStatus::ACTUAL);
+}
+
+int SegmentedIndex::GetDocumentCount() const
+{
+    std::shared_lock lock(mutex_);
+    size_t document_count = active_->GetLiveDocumentCount();
+    for (const SegmentPtr& segment : sealed_)
+    {
+        document_count += segment->GetLiveDocumentCount();
+    }
+    return static_cast<int>(document_count);
+}
+
+void SegmentedIndex::Flush()
+{
+    bool start_merge = false;
+    {
+        std::unique_lock lock(mutex_);
+        if (active_->GetDocumentCount() == 0)
+        {
+            return;
+        }
+        SealActiveSegment();
+        start_merge = ScheduleMerge();
+    }
+    if (start_merge)
+    {
+        StartMerge();
+    }
+}
+
+void SegmentedIndex::WaitForMerges() const
+{
+    std::unique_lock lock(mutex_);
+    merge_finished_.wait(lock, [this] { return merging_.empty(); });
+}
+
+void SegmentedIndex::Optimize(DocumentOrder order)
+{
+    {
+        std::unique_lock lock(mutex_);
+        merge_finished_.wait(lock, [this] { return merging_.empty(); });
+        if (active_->GetDocumentCount() > 0)
+        {
+            SealActiveSegment();
+        }
+        sealed_.erase(
+            std::remove_if(sealed_.begin(), sealed_.end(), [](const SegmentPtr& segment) { return segment->GetLiveDocumentCount() == 0; }),
+            sealed_.end());
+        if (sealed_.empty())
+        {
+            return;
+        }
+        merging_ = sealed_;
+        merge_order_ = order;
+    }
+    StartMerge();
+    WaitForMerges();
+}
+
+SegmentedIndex::Stats SegmentedIndex::GetStats() const
+{
+    std::shared_lock lock(mutex_);
+    Stats stats;
+    stats.segment_count = sealed_.size() + (active_->GetDocumentCount() > 0 ? 1 : 0);
+    auto add_segment = [&stats](const IndexSegment& segment)
+    {
+        stats.live_document_count += segment.GetLiveDocumentCount();
+        stats.deleted_document_count += segment.GetDocumentCount() - segment.GetLiveDocumentCount();
+        stats.posting_bytes += segment.GetPostingBytes();
+    };
+    add_segment(*active_);
+    size_t filtered_term_count = 0;
+    for (const SegmentPtr& segment : sealed_)
+    {
+        add_segment(*segment);
+        const TermFilter::Stats filter_stats = segment->GetFilterStats();
+        stats.term_filter_false_positive_rate += filter_stats.false_positive_rate * filter_stats.term_count;
+        filtered_term_count += filter_stats.term_count;
+    }
+    if (filtered_term_count > 0)
+    {
+        stats.term_filter_false_positive_rate /= filtered_term_count;
+    }
+    stats.merge_count = merge_count_;
+    return stats;
+}
+
+// private methods
+SegmentedIndex::Query SegmentedIndex::ParseQuery(const std::string_view text) const
+{
+    return ParseQueryText(text, stop_words_);
+}
+
+std::pair<IndexSegment*, uint32_t> SegmentedIndex::FindLiveDocument(int document_id) const
+{
+    const uint32_t ordinal = active_->FindOrdinal(document_id);
+    if (ordinal != IndexSegment::NO_ORDINAL)
+    {
+        return { active_.get(), ordinal };
+    }
+    for (const SegmentPtr& segment : sealed_)
+    {
+        const uint32_t sealed_ordinal = segment->FindOrdinal(document_id);
+        if (sealed_ordinal != IndexSegment::NO_ORDINAL)
+        {
+            return { segment.get(), sealed_ordinal };
+        }
+    }
+    return { nullptr, IndexSegment::NO_ORDINAL };
+}
+
+void SegmentedIndex::SealActiveSegment()
+{
+    active_->Seal();
+    sealed_.push_back(std::move(active_));
+    active_ = std::make_shared<IndexSegment>(options_.segment_size);
+}
+
+bool SegmentedIndex::ScheduleMerge()
+{
+    if (!merging_.empty())
+    {
+        return false;
+    }
+    sealed_.erase(
+        std::remove_if(sealed_.begin(), sealed_.end(), [](const SegmentPtr& segment) { return segment->GetLiveDocumentCount() == 0; }),
+        sealed_.end());
+
+    // Tier t holds segments of [segment_size * merge_factor^t, segment_size * merge_factor^(t+1)) live documents;
+    // merging the segments of the lowest full tier keeps the segment count logarithmic in the index size
+    std::map<size_t, std::vector<SegmentPtr>> tiers;
+    for (const SegmentPtr& segment : sealed_)
+    {
+        size_t tier = 0;
+        for (size_t limit = options_.segment_size * options_.merge_factor; segment->GetLiveDocumentCount() >= limit; limit *= options_.merge_factor)
+        {
+            ++tier;
+        }
+        tiers[tier].push_back(segment);
+    }
+    for (auto& [tier, segments] : tiers)
+    {
+        if (segments.size() >= options_.merge_factor)
+        {
+            merging_.assign(segments.begin(), segments.begin() + options_.merge_factor);
+            return true;
+        }
+    }
+
+    // A segment that is mostly tombstones is rewritten on its own
+    for (const SegmentPtr& segment : sealed_)
+    {
+        if (segment->GetLiveDocumentCount() * 2 < segment->GetDocumentCount())
+        {
+            merging_.push_back(segment);
+            return true;
+        }
+    }
+    return false;
+}
+
+void SegmentedIndex::StartMerge()
+{
+    // Without a merge thread the pool runs the merge right here
+    merge_pool_->Submit([this] { RunMerges(); });
+}
+
+void SegmentedIndex::RunMerges()
+{
+    std::vector<SegmentPtr> sources;
+    DocumentOrder order = DocumentOrder::BY_ID;
+    {
+        std::shared_lock lock(mutex_);
+        sources = merging_;
+        order = merge_order_;
+    }
+    while (true)
+    {
+        // The sources are sealed, they are read without the lock
+        std::vector<std::vector<uint32_t>> new_ordinals;
+        const SegmentPtr merged = IndexSegment::Merge(sources, new_ordinals, order);
+
+        std::unique_lock lock(mutex_);
+        for (const auto& [segment, ordinal] : merge_deletions_)
+        {
+            const size_t source = std::find_if(sources.begin(), sources.end(),
+                [segment = segment](const SegmentPtr& source) { return source.get() == segment; }) - sources.begin();
+            if (new_ordinals[source][ordinal] != IndexSegment::NO_ORDINAL)
+            {
+                merged->Delete(new_ordinals[source][ordinal]);
+            }
+        }
+        merge_deletions_.clear();
+
+        // The merged segment takes the place of its first source
+        std::vector<SegmentPtr> sealed;
+        for (const SegmentPtr& segment : sealed_)
+        {
+            if (segment == sources.front())
+            {
+                sealed.push_back(merged);
+            }
+            else if (std::find(sources.begin(), sources.end(), segment) == sources.end())
+            {
+                sealed.push_back(segment);
+            }
+        }
+        sealed_ = std::move(sealed);
+        ++merge_count_;
+        merging_.clear();
+        merge_order_ = DocumentOrder::BY_ID;
+
+        if (!ScheduleMerge())
+        {
+            merge_finished_.notify_all();
+            return;
+        }
+        sources = merging_;
+        order = merge_order_;
+    }
+}
@@ -0,0 +1,291 @@
+#pragma once
+#include "search_server.h"
+#include "index_segment.h"
+#include "query_parser.h"
+#include <condition_variable>
+#include <execution>
+#include <memory>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+struct SegmentedIndexOptions
+{
+    // Documents of the active segment; a full segment is sealed and a new one is started
+    size_t segment_size = 4096;
+    // Sealed segments of one size tier that are merged into a segment of the next tier
+    size_t merge_factor = 4;
+    // Merge on a background thread; without it merges run inside AddDocument and RemoveDocument
+    bool background_merge = true;
+    // Workers that search the segments of an execution::par query
+    size_t thread_count = THREAD_COUNT;
+};
+
+// Log-structured alternative to SearchServer for a high ingest rate.
+// New documents go to a small active segment, a full one is sealed and never changes again
+// except for tombstones. Sealed segments of the same size tier are merged in the background,
+// the merge drops deleted documents. A query takes a snapshot of the segments, so it neither
+// blocks nor is blocked by merges; it waits for writers only while it reads the active segment.
+// Relevance uses the global IDF: document frequencies are summed over all the segments.
+// All the methods may be called concurrently.
+class SegmentedIndex
+{
+public:
+    struct Stats
+    {
+        size_t segment_count = 0;
+        size_t live_document_count = 0;
+        // Deleted documents whose postings have not been merged away yet
+        size_t deleted_document_count = 0;
+        size_t merge_count = 0;
+        // Of the term filters of the sealed segments, weighted by their words
+        double term_filter_false_positive_rate = 0.0;
+        // Encoded postings of all the segments
+        size_t posting_bytes = 0;
+    };
+
+    template <typename StringContainer>
+    explicit SegmentedIndex(const StringContainer& stop_words, const SegmentedIndexOptions& options = {});
+
+    explicit SegmentedIndex(const std::string_view stop_words_text, const SegmentedIndexOptions& options = {});
+
+    explicit SegmentedIndex(const std::string& stop_words_text, const SegmentedIndexOptions& options = {});
+
+    void AddDocument(int document_id, const std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+
+    // Does nothing if there is no such document
+    void RemoveDocument(int document_id);
+
+    // execution::sep|par, string, [](document_id, status, rating) { return; }
+    template <typename DocumentFilter, typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(const ExecutionPolicy& policy, const std::string_view raw_query, DocumentFilter document_filter) const;
+
+    // execution::sep|par, string, status
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(const ExecutionPolicy& policy, const std::string_view raw_query, DocumentStatus document_status) const;
+
+    // execution::sep|par, string
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(const ExecutionPolicy& policy, const std::string_view raw_query) const;
+
+    std::vector<Document> FindTopDocuments(const std::string_view raw_query, DocumentStatus document_status) const;
+
+    std::vector<Document> FindTopDocuments(const std::string_view raw_query) const;
+
+    int GetDocumentCount() const;
+
+    // Seals the active segment even if it is not full
+    void Flush();
+
+    // Blocks until no merge is running or pending
+    void WaitForMerges() const;
+
+    // Merges all the documents into one segment with the given order and waits for it.
+    // Later tiered merges put the documents back in the order of ids.
+    void Optimize(DocumentOrder order = DocumentOrder::LOCALITY);
+
+    Stats GetStats() const;
+
+private:
+    using SegmentPtr = std::shared_ptr<IndexSegment>;
+
+    using Query = ParsedQuery;
+
+    // A plus word with its weight in this query
+    struct WeightedWord
+    {
+        std::string_view word;
+        double inverse_document_freq;
+    };
+
+    StopWords stop_words_;
+    const SegmentedIndexOptions options_;
+    // Guards the segment lists and the active segment content
+    mutable std::shared_mutex mutex_;
+    mutable std::condition_variable_any merge_finished_;
+    SegmentPtr active_;
+    std::vector<SegmentPtr> sealed_;
+    // Sources of the running merge and the deletions made in them since it started
+    std::vector<SegmentPtr> merging_;
+    std::vector<std::pair<IndexSegment*, uint32_t>> merge_deletions_;
+    DocumentOrder merge_order_ = DocumentOrder::BY_ID;
+    size_t merge_count_ = 0;
+    // Declared last to be destroyed first: the pending merges finish while the members above still exist
+    std::unique_ptr<ThreadPool> query_pool_;
+    std::unique_ptr<ThreadPool> merge_pool_;
+
+    Query ParseQuery(const std::string_view text) const;
+
+    // Requires the lock; the sealed segment, or nullptr, and the ordinal of a live document
+    std::pair<IndexSegment*, uint32_t> FindLiveDocument(int document_id) const;
+
+    // Requires the exclusive lock
+    void SealActiveSegment();
+
+    // Requires the exclusive lock; picks the sources of the next merge, returns false if none is needed
+    bool ScheduleMerge();
+
+    void StartMerge();
+
+    void RunMerges();
+
+    template <typename DocumentFilter>
+    static std::vector<Document> SearchSegment(const IndexSegment& segment, const std::vector<WeightedWord>& plus_words,
+        const std::vector<std::string_view>& minus_words, DocumentFilter& document_filter);
+};
+
+template <typename StringContainer>
+SegmentedIndex::SegmentedIndex(const StringContainer& stop_words, const SegmentedIndexOptions& options)
+    : stop_words_(MakeStopWords(stop_words))
+    , options_(options)
+    , active_(std::make_shared<IndexSegment>(options.segment_size))
+    , query_pool_(std::make_unique<ThreadPool>(options.thread_count))
+    , merge_pool_(std::make_unique<ThreadPool>(options.background_merge ? 1 : 0))
+{
+    using namespace std::string_literals;
+    if (options.segment_size == 0 || options.merge_factor < 2)
+    {
+        throw std::invalid_argument("Segment size must be positive and merge factor at least 2"s);
+    }
+}
+
+// execution::sep|par, string, [](document_id, status, rating) { return; }
+template <typename DocumentFilter, typename ExecutionPolicy>
+std::vector<Document> SegmentedIndex::FindTopDocuments(const ExecutionPolicy& policy, const std::string_view raw_query, DocumentFilter document_filter) const
+{
+    const Query query = ParseQuery(raw_query);
+
+    std::vector<SegmentPtr> segments;
+    std::vector<WeightedWord> plus_words;
+    std::vector<Document> matched_documents;
+    {
+        std::shared_lock lock(mutex_);
+        segments = sealed_;
+        size_t document_count = active_->GetLiveDocumentCount();
+        for (const SegmentPtr& segment : segments)
+        {
+            document_count += segment->GetLiveDocumentCount();
+        }
+        for (const std::string_view word : query.plus_words)
+        {
+            size_t document_freq = active_->GetLiveDocumentFreq(word);
+            for (const SegmentPtr& segment : segments)
+            {
+                document_freq += segment->GetLiveDocumentFreq(word);
+            }
+            if (document_freq > 0)
+            {
+                plus_words.push_back({ word, std::log(document_count * 1.0 / document_freq) });
+            }
+        }
+        // The active segment changes under writers, it is searched before the lock is released
+        matched_documents = SearchSegment(*active_, plus_words, query.minus_words, document_filter);
+    }
+    if (plus_words.empty())
+    {
+        return {};
+    }
+
+    std::vector<std::vector<Document>> segment_documents(segments.size());
+    auto search = [&](size_t i)
+    {
+        segment_documents[i] = SearchSegment(*segments[i], plus_words, query.minus_words, document_filter);
+    };
+    if constexpr (std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::sequenced_policy>)
+    {
+        for (size_t i = 0; i < segments.size(); ++i)
+        {
+            search(i);
+        }
+    }
+    else
+    {
+        query_pool_->ParallelFor(0, segments.size(), search);
+    }
+    for (std::vector<Document>& documents : segment_documents)
+    {
+        matched_documents.insert(matched_documents.end(), documents.begin(), documents.end());
+    }
+    return SearchServer::SelectTopDocuments(std::move(matched_documents), MAX_RESULT_DOCUMENT_COUNT);
+}
+
+// execution::sep|par, string, status
+template <typename ExecutionPolicy>
+std::vector<Document> SegmentedIndex::FindTopDocuments(const ExecutionPolicy& policy, const std::string_view raw_query, DocumentStatus document_status) const
+{
+    return FindTopDocuments(policy, raw_query,
+        [document_status](int document_id, DocumentStatus status, int rating)
+            { return status == document_status; });
+}
+
+// execution::sep|par, string
+template <typename ExecutionPolicy>
+std::vector<Document> SegmentedIndex::FindTopDocuments(const ExecutionPolicy& policy, const std::string_view raw_query) const
+{
+    return FindTopDocuments(policy, raw_query, DocumentStatus::ACTUAL);
+}
+
+template <typename DocumentFilter>
+std::vector<Document> SegmentedIndex::SearchSegment(const IndexSegment& segment, const std::vector<WeightedWord>& plus_words,
+    const std::vector<std::string_view>& minus_words, DocumentFilter& document_filter)
+{
+    enum : uint8_t { UNSEEN, SCORED, SKIPPED };
+    const size_t document_count = segment.GetDocumentCount();
+    if (document_count == 0)
+    {
+        return {};
+    }
+    // Dense accumulator indexed by ordinal; minus words are marked first so excluded documents are never scored
+    std::vector<uint8_t> states(document_count, UNSEEN);
+    std::vector<double> relevances(document_count, 0.0);
+    std::vector<uint32_t> scored_ordinals;
+    PostingList::DecodedBlock block;
+    for (const std::string_view word : minus_words)
+    {
+        if (const PostingList* postings = segment.FindPostings(word))
+        {
+            postings->ForEach([&states](int ordinal, double) { states[ordinal] = SKIPPED; });
+        }
+    }
+    for (const WeightedWord& plus_word : plus_words)
+    {
+        const PostingList* postings = segment.FindPostings(plus_word.word);
+        if (postings == nullptr)
+        {
+            continue;
+        }
+        for (size_t block_index = 0; block_index < postings->GetBlockCount(); ++block_index)
+        {
+            postings->DecodeBlock(block_index, block);
+            for (size_t i = 0; i < block.size; ++i)
+            {
+                const uint32_t ordinal = static_cast<uint32_t>(block.document_ids[i]);
+                if (states[ordinal] == UNSEEN)
+                {
+                    const bool is_wanted = !segment.IsDeleted(ordinal)
+                        && document_filter(segment.GetDocumentId(ordinal), segment.GetStatus(ordinal), segment.GetRating(ordinal));
+                    states[ordinal] = is_wanted ? SCORED : SKIPPED;
+                    if (is_wanted)
+                    {
+                        scored_ordinals.push_back(ordinal);
+                    }
+                }
+                if (states[ordinal] == SCORED)
+                {
+                    relevances[ordinal] += block.term_freqs[i] * plus_word.inverse_document_freq;
+                }
+            }
+        }
+    }
+
+    std::vector<Document> matched_documents;
+    matched_documents.reserve(scored_ordinals.size());
+    for (const uint32_t ordinal : scored_ordinals)
+    {
+        matched_documents.push_back({ segment.GetDocumentId(ordinal), relevances[ordinal], segment.GetRating(ordinal) });
+    }
+    return SearchServer::SelectTopDocuments(std::move(matched_documents), MAX_RESULT_DOCUMENT_COUNT);
+}
@@ -0,0 +1,196 @@
+#include "synthetic_corpus.h"
+#include "string_processing.h"
+#include <algorithm>
+#include <cmath>
+
+SyntheticRandom::SyntheticRandom(uint64_t seed)
+    : engine_(seed)
+{
+}
+
+double SyntheticRandom::NextDouble()
+{
+    // 53 random bits give every representable double in [0, 1) with the step 2^-53
+    return static_cast<double>(engine_() >> 11) * 0x1.0p-53;
+}
+
+int64_t SyntheticRandom::NextInt(int64_t min, int64_t max)
+{
+    const uint64_t range = static_cast<uint64_t>(max - min) + 1;
+    return min + static_cast<int64_t>(range == 0 ? engine_() : engine_() % range);
+}
+
+bool SyntheticRandom::NextBool(double probability)
+{
+    return NextDouble() < probability;
+}
+
+ZipfDistribution::ZipfDistribution(size_t size, double exponent)
+    : cumulative_(size)
+{
+    double sum = 0.0;
+    for (size_t rank = 0; rank < size; ++rank)
+    {
+        sum += 1.0 / std::pow(static_cast<double>(rank + 1), exponent);
+        cumulative_[rank] = sum;
+    }
+    for (double& value : cumulative_)
+    {
+        value /= sum;
+    }
+}
+
+size_t ZipfDistribution::operator()(SyntheticRandom& random) const
+{
+    const auto it = std::upper_bound(cumulative_.begin(), cumulative_.end(), random.NextDouble());
+    return std::min(static_cast<size_t>(it - cumulative_.begin()), cumulative_.size() - 1);
+}
+
+std::string MakeSyntheticWord(size_t rank)
+{
+    static const std::string consonants = "bdfgklmnprstvz";
+    static const std::string vowels = "aeiou";
+    const size_t syllable_count = consonants.size() * vowels.size();
+
+    // Bijective numeration, so every rank maps to a distinct word
+    std::string word;
+    for (++rank; rank > 0; rank /= syllable_count)
+    {
+        --rank;
+        word += consonants[rank % syllable_count / vowels.size()];
+        word += vowels[rank % vowels.size()];
+    }
+    return word;
+}
+
+namespace
+{
+    // Stop words and typos start with letters that never begin a vocabulary word
+    std::string MakeStopWord(size_t index)
+    {
+        return "x" + MakeSyntheticWord(index);
+    }
+
+    std::string MakeUnknownWord(SyntheticRandom& random)
+    {
+        return "q" + MakeSyntheticWord(static_cast<size_t>(random.NextInt(0, 1 << 20)));
+    }
+
+    DocumentStatus MakeStatus(SyntheticRandom& random, double non_actual_rate)
+    {
+        if (!random.NextBool(non_actual_rate))
+        {
+            return DocumentStatus::ACTUAL;
+        }
+        return static_cast<DocumentStatus>(random.NextInt(1, 3));
+    }
+
+    std::vector<int> MakeRatings(SyntheticRandom& random)
+    {
+        std::vector<int> ratings(static_cast<size_t>(random.NextInt(1, 5)));
+        for (int& rating : ratings)
+        {
+            rating = static_cast<int>(random.NextInt(-10, 10));
+        }
+        return ratings;
+    }
+}
+
+SyntheticCorpus GenerateCorpus(const CorpusConfig& config)
+{
+    SyntheticRandom random(config.seed);
+    const ZipfDistribution zipf(config.vocabulary_size, config.zipf_exponent);
+
+    SyntheticCorpus corpus;
+    corpus.vocabulary.reserve(config.vocabulary_size);
+    for (size_t rank = 0; rank < config.vocabulary_size; ++rank)
+    {
+        corpus.vocabulary.push_back(MakeSyntheticWord(rank));
+    }
+    std::vector<std::string> stop_words;
+    for (size_t i = 0; i < config.stop_word_count; ++i)
+    {
+        stop_words.push_back(MakeStopWord(i));
+        corpus.stop_words += (i == 0 ? "" : " ") + stop_words.back();
+    }
+
+    corpus.documents.reserve(config.document_count);
+    for (size_t i = 0; i < config.document_count; ++i)
+    {
+        SyntheticDocument document;
+        document.id = static_cast<int>(i);
+        document.status = MakeStatus(random, config.non_actual_rate);
+        document.ratings = MakeRatings(random);
+
+        if (!corpus.documents.empty() && random.NextBool(config.duplicate_rate))
+        {
+            // Same words as an earlier document, but in reverse order
+            const auto& original = corpus.documents[static_cast<size_t>(random.NextInt(0, corpus.documents.size() - 1))];
+            std::vector<std::string_view> words = SplitIntoWords(original.text);
+            std::reverse(words.begin(), words.end());
+            for (const std::string_view word : words)
+            {
+                document.text += (document.text.empty() ? "" : " ") + std::string(word);
+            }
+        }
+        else
+        {
+            const size_t length = static_cast<size_t>(random.NextInt(config.min_document_length, config.max_document_length));
+            // Topic t owns the vocabulary ranks t, t + topic_count, t + 2 * topic_count, ...
+            const size_t topic = config.topic_count > 0 ? static_cast<size_t>(random.NextInt(0, config.topic_count - 1)) : 0;
+            auto next_word = [&]() -> const std::string&
+            {
+                if (config.topic_count > 0 && random.NextBool(config.topic_word_rate))
+                {
+                    return corpus.vocabulary[(zipf(random) * config.topic_count + topic) % config.vocabulary_size];
+                }
+                return corpus.vocabulary[zipf(random)];
+            };
+            for (size_t j = 0; j < length; ++j)
+            {
+                const std::string& word = (!stop_words.empty() && random.NextBool(config.stop_word_ratio))
+                    ? stop_words[static_cast<size_t>(random.NextInt(0, stop_words.size() - 1))]
+                    : next_word();
+                document.text += (j == 0 ? "" : " ") + word;
+            }
+        }
+        corpus.documents.push_back(std::move(document));
+    }
+    return corpus;
+}
+
+std::vector<std::string> GenerateQueries(const SyntheticCorpus& corpus, const QueryConfig& config)
+{
+    SyntheticRandom random(config.seed);
+    const ZipfDistribution zipf(corpus.vocabulary.size(), config.zipf_exponent);
+    auto next_word = [&]()
+    {
+        if (corpus.vocabulary.empty() || random.NextBool(config.unknown_word_rate))
+        {
+            return MakeUnknownWord(random);
+        }
+        return corpus.vocabulary[zipf(random)];
+    };
+
+    std::vector<std::string> queries;
+    queries.reserve(config.query_count);
+    for (size_t i = 0; i < config.query_count; ++i)
+    {
+        std::string query;
+        const int64_t plus_count = random.NextInt(config.min_plus_words, config.max_plus_words);
+        for (int64_t j = 0; j < plus_count; ++j)
+        {
+            query += (query.empty() ? "" : " ") + next_word();
+        }
+        if (config.max_minus_words > 0 && random.NextBool(config.minus_query_rate))
+        {
+            const int64_t minus_count = random.NextInt(1, config.max_minus_words);
+            for (int64_t j = 0; j < minus_count; ++j)
+            {
+                query += (query.empty() ? "-" : " -") + next_word();
+            }
+        }
+        queries.push_back(std::move(query));
+    }
+    return queries;
+}
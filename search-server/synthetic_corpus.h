@@ -0,0 +1,97 @@
+#pragma once
+#include "document.h"
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+// Seeded generator of reproducible test corpora.
+// All sampling goes through raw std::mt19937_64 output (which is fully specified by the standard),
+// so the same seed yields the same corpus with every compiler and standard library.
+
+struct CorpusConfig
+{
+    uint64_t seed = 42;
+    size_t document_count = 10000;
+    size_t vocabulary_size = 20000;
+    // Exponent s of the Zipf law: P(rank k) ~ 1 / k^s
+    double zipf_exponent = 1.0;
+    size_t min_document_length = 8;
+    size_t max_document_length = 64;
+    size_t stop_word_count = 16;
+    // Share of document words that are stop words
+    double stop_word_ratio = 0.1;
+    // Share of documents repeating the word set of an earlier document
+    double duplicate_rate = 0.01;
+    // Share of documents with a status other than ACTUAL
+    double non_actual_rate = 0.1;
+    // Topics of the documents; a document takes a share of its words from the vocabulary part of its topic.
+    // With no topics documents are independent of each other
+    size_t topic_count = 0;
+    double topic_word_rate = 0.5;
+};
+
+struct SyntheticDocument
+{
+    int id = 0;
+    std::string text;
+    DocumentStatus status = DocumentStatus::ACTUAL;
+    std::vector<int> ratings;
+};
+
+struct SyntheticCorpus
+{
+    std::string stop_words;
+    std::vector<std::string> vocabulary;
+    std::vector<SyntheticDocument> documents;
+};
+
+struct QueryConfig
+{
+    uint64_t seed = 4242;
+    size_t query_count = 1000;
+    size_t min_plus_words = 1;
+    size_t max_plus_words = 5;
+    size_t max_minus_words = 2;
+    // Probability that a query contains minus words at all
+    double minus_query_rate = 0.3;
+    // Share of query words absent from the vocabulary (typos)
+    double unknown_word_rate = 0.05;
+    double zipf_exponent = 1.0;
+};
+
+class SyntheticRandom
+{
+public:
+    explicit SyntheticRandom(uint64_t seed);
+
+    // Uniform in [0, 1)
+    double NextDouble();
+
+    // Uniform in [min, max]
+    int64_t NextInt(int64_t min, int64_t max);
+
+    bool NextBool(double probability);
+
+private:
+    std::mt19937_64 engine_;
+};
+
+class ZipfDistribution
+{
+public:
+    ZipfDistribution(size_t size, double exponent);
+
+    // Returns rank in [0, size)
+    size_t operator()(SyntheticRandom& random) const;
+
+private:
+    std::vector<double> cumulative_;
+};
+
+// Deterministic pronounceable word for the given rank, e.g. 0 -> "ba", 1 -> "be", 70 -> "baba"
+std::string MakeSyntheticWord(size_t rank);
+
+SyntheticCorpus GenerateCorpus(const CorpusConfig& config);
+
+std::vector<std::string> GenerateQueries(const SyntheticCorpus& corpus, const QueryConfig& config);
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include "term_dictionary.h"
+#include "memory_usage.h"
+#include <algorithm>
+
+int TermDictionary::AddTerm(std::string_view word)
+{
+    const auto it = term_ids_.find(word);
+    if (it != term_ids_.end())
+    {
+        return it->second;
+    }
+    int term_id;
+    if (free_ids_.empty())
+    {
+        term_id = static_cast<int>(terms_.size());
+        terms_.emplace_back(word);
+        // libstdc++ deque stores strings in 512-byte chunks
+        if ((terms_.size() - 1) % (512 / sizeof(std::string)) == 0)
+        {
+            heap_bytes_ += GetHeapBlockBytes(512);
+        }
+    }
+    else
+    {
+        term_id = free_ids_.back();
+        free_ids_.pop_back();
+        terms_[static_cast<size_t>(term_id)] = word;
+    }
+    const std::string& term = terms_[static_cast<size_t>(term_id)];
+    term_ids_.emplace(term, term_id);
+    heap_bytes_ += GetStringHeapBytes(term) + GetTreeNodeBytes<std::pair<const std::string_view, int>>();
+    if (filter_.GetTermCount() >= filter_.GetCapacity())
+    {
+        RebuildFilter();
+    }
+    else
+    {
+        filter_.Add(word);
+    }
+    return term_id;
+}
+
+int TermDictionary::FindTerm(std::string_view word) const
+{
+    if (!filter_.MayContain(word))
+    {
+        return NO_TERM;
+    }
+    const auto it = term_ids_.find(word);
+    return it == term_ids_.end() ? NO_TERM : it->second;
+}
+
+void TermDictionary::RemoveTerm(int term_id)
+{
+    std::string& term = terms_[static_cast<size_t>(term_id)];
+    term_ids_.erase(term);
+    heap_bytes_ -= GetStringHeapBytes(term) + GetTreeNodeBytes<std::pair<const std::string_view, int>>();
+    std::string().swap(term);
+    free_ids_.push_back(term_id);
+    // The bits of removed words stay set and only add false positives
+    if (filter_.GetTermCount() >= 2 * term_ids_.size() && filter_.GetCapacity() > MIN_FILTER_CAPACITY)
+    {
+        RebuildFilter();
+    }
+}
+
+std::string_view TermDictionary::GetTerm(int term_id) const
+{
+    return terms_[static_cast<size_t>(term_id)];
+}
+
+size_t TermDictionary::GetTermCount() const
+{
+    return term_ids_.size();
+}
+
+bool TermDictionary::MayContain(std::string_view word) const
+{
+    return filter_.MayContain(word);
+}
+
+TermFilter::Stats TermDictionary::GetFilterStats() const
+{
+    return filter_.GetStats();
+}
+
+size_t TermDictionary::GetMemoryBytes() const
+{
+    return heap_bytes_ + GetVectorHeapBytes(free_ids_) + filter_.GetMemoryBytes();
+}
+
+// private methods
+void TermDictionary::RebuildFilter()
+{
+    TermFilter filter(std::max(MIN_FILTER_CAPACITY, term_ids_.size() * 2));
+    for (const auto& [term, term_id] : term_ids_)
+    {
+        filter.Add(term);
+    }
+    filter_ = std::move(filter);
+}
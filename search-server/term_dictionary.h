@@ -0,0 +1,53 @@
+#pragma once
+#include "term_filter.h"
+#include <deque>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Owns the text of every indexed word and numbers words densely: a new word gets the id of a removed one
+// if there is any, otherwise the next unused id. Views returned by GetTerm stay valid until the word is removed.
+class TermDictionary
+{
+public:
+    static constexpr int NO_TERM = -1;
+
+    // Id of the word, the word is added if it is new
+    int AddTerm(std::string_view word);
+
+    // NO_TERM if the word has never been added
+    int FindTerm(std::string_view word) const;
+
+    // False means the word has never been added; answered by the filter without a tree search
+    bool MayContain(std::string_view word) const;
+
+    // The id must be in use; it is given to the next new word
+    void RemoveTerm(int term_id);
+
+    std::string_view GetTerm(int term_id) const;
+
+    // Words in the dictionary now
+    size_t GetTermCount() const;
+
+    TermFilter::Stats GetFilterStats() const;
+
+    // Heap memory of the words, the index over them and the filter; O(1)
+    size_t GetMemoryBytes() const;
+
+private:
+    // deque never relocates its elements, so views of the strings survive insertions
+    std::deque<std::string> terms_;
+    std::map<std::string_view, int> term_ids_;
+    // Ids of removed words, their strings are empty
+    std::vector<int> free_ids_;
+    static constexpr size_t MIN_FILTER_CAPACITY = 1024;
+
+    // Rebuilt from the words in the dictionary at twice their number when it fills up, or when removed words
+    // make up half of it, so additions and removals stay amortized O(1)
+    TermFilter filter_{ MIN_FILTER_CAPACITY };
+    // Heap memory of terms_ and term_ids_, kept up to date by AddTerm and RemoveTerm
+    size_t heap_bytes_ = 0;
+
+    void RebuildFilter();
+};
@@ -0,0 +1,108 @@
+#include "term_filter.h"
+#include "memory_usage.h"
+#include <bitset>
+#include <cmath>
+
+namespace
+{
+    // 12 bits and 6 probes per word: about 0.5% false positives for a blocked filter
+    constexpr size_t BITS_PER_TERM = 12;
+    constexpr size_t PROBE_COUNT = 6;
+    constexpr size_t BLOCK_BITS = 512;
+
+    // FNV-1a followed by the splitmix64 finalizer, which spreads the FNV bits over the whole word
+    uint64_t HashWord(std::string_view word)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for (const char c : word)
+        {
+            hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+        }
+        hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ull;
+        hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebull;
+        return hash ^ (hash >> 31);
+    }
+
+    // Bit of the probe inside the block: double hashing on the lower half of the hash,
+    // the upper half chooses the block
+    size_t GetProbeBit(uint64_t hash, size_t probe)
+    {
+        const uint32_t first = static_cast<uint32_t>(hash);
+        const uint32_t step = (first >> 9) | 1;
+        return (first + probe * step) % BLOCK_BITS;
+    }
+}
+
+TermFilter::TermFilter(size_t capacity)
+    : blocks_((capacity * BITS_PER_TERM + BLOCK_BITS - 1) / BLOCK_BITS + 1)
+{
+}
+
+void TermFilter::Add(std::string_view word)
+{
+    const uint64_t hash = HashWord(word);
+    Block& block = blocks_[GetBlockIndex(hash)];
+    for (size_t probe = 0; probe < PROBE_COUNT; ++probe)
+    {
+        const size_t bit = GetProbeBit(hash, probe);
+        block.words[bit / 64] |= uint64_t{ 1 } << (bit % 64);
+    }
+    ++term_count_;
+}
+
+bool TermFilter::MayContain(std::string_view word) const
+{
+    const uint64_t hash = HashWord(word);
+    const Block& block = blocks_[GetBlockIndex(hash)];
+    for (size_t probe = 0; probe < PROBE_COUNT; ++probe)
+    {
+        const size_t bit = GetProbeBit(hash, probe);
+        if ((block.words[bit / 64] & (uint64_t{ 1 } << (bit % 64))) == 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t TermFilter::GetCapacity() const
+{
+    return (blocks_.size() - 1) * BLOCK_BITS / BITS_PER_TERM;
+}
+
+size_t TermFilter::GetTermCount() const
+{
+    return term_count_;
+}
+
+size_t TermFilter::GetMemoryBytes() const
+{
+    return GetHeapBlockBytes(blocks_.size() * sizeof(Block));
+}
+
+TermFilter::Stats TermFilter::GetStats() const
+{
+    Stats stats;
+    stats.term_count = term_count_;
+    stats.byte_size = blocks_.size() * sizeof(Block);
+    double false_positive_sum = 0.0;
+    for (const Block& block : blocks_)
+    {
+        size_t set_bits = 0;
+        for (const uint64_t word : block.words)
+        {
+            set_bits += std::bitset<64>(word).count();
+        }
+        // An unknown word passes if all its probes hit set bits of its block
+        false_positive_sum += std::pow(static_cast<double>(set_bits) / BLOCK_BITS, static_cast<double>(PROBE_COUNT));
+    }
+    stats.false_positive_rate = false_positive_sum / blocks_.size();
+    return stats;
+}
+
+// private methods
+size_t TermFilter::GetBlockIndex(uint64_t hash) const
+{
+    // Multiply-shift maps the upper 32 bits onto [0, block count) without a division
+    return static_cast<size_t>(((hash >> 32) * blocks_.size()) >> 32);
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Blocked Bloom filter of words: all the bits of a word lie in one 64-byte block, so rejecting
+// an unknown word costs a hash and a single cache miss. There are no false negatives.
+// Words can't be removed: the owner rebuilds a filter that has grown past its capacity or holds many removed words.
+class TermFilter
+{
+public:
+    struct Stats
+    {
+        size_t term_count = 0;
+        size_t byte_size = 0;
+        // Estimated from the share of set bits in every block
+        double false_positive_rate = 0.0;
+    };
+
+    // Sized for `capacity` words at about 0.5% false positives
+    explicit TermFilter(size_t capacity = 0);
+
+    void Add(std::string_view word);
+
+    bool MayContain(std::string_view word) const;
+
+    // Words the filter was sized for; beyond it the false positive rate grows quickly
+    size_t GetCapacity() const;
+
+    // Additions, removed words and repeated additions included
+    size_t GetTermCount() const;
+
+    size_t GetMemoryBytes() const;
+
+    // O(size of the filter)
+    Stats GetStats() const;
+
+private:
+    struct alignas(64) Block
+    {
+        uint64_t words[8];
+    };
+
+    std::vector<Block> blocks_;
+    size_t term_count_ = 0;
+
+    size_t GetBlockIndex(uint64_t hash) const;
+};
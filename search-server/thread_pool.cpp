@@ -0,0 +1,219 @@
+#include "thread_pool.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
+namespace
+{
+    thread_local const ThreadPool* current_pool = nullptr;
+    thread_local size_t current_worker_index = 0;
+}
+
+double ThreadPool::Stats::GetUtilization() const
+{
+    if (workers.empty() || uptime.count() == 0)
+    {
+        return 0.0;
+    }
+    std::chrono::nanoseconds busy_time{};
+    for (const WorkerStats& worker : workers)
+    {
+        busy_time += worker.busy_time;
+    }
+    return static_cast<double>(busy_time.count()) / static_cast<double>(uptime.count() * static_cast<int64_t>(workers.size()));
+}
+
+ThreadPool::ThreadPool(size_t thread_count, bool pin_threads)
+{
+    // Every worker must exist before the first one starts looking for tasks to steal
+    for (size_t i = 0; i < thread_count; ++i)
+    {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < thread_count; ++i)
+    {
+        workers_[i]->thread = std::thread([this, i] { RunWorker(i); });
+#ifdef __linux__
+        if (pin_threads)
+        {
+            cpu_set_t cpu_set;
+            CPU_ZERO(&cpu_set);
+            CPU_SET(i % std::max(1u, std::thread::hardware_concurrency()), &cpu_set);
+            pthread_setaffinity_np(workers_[i]->thread.native_handle(), sizeof(cpu_set), &cpu_set);
+        }
+#endif
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard guard(mutex_);
+        stopping_ = true;
+    }
+    wake_up_.notify_all();
+    for (const auto& worker : workers_)
+    {
+        worker->thread.join();
+    }
+}
+
+size_t ThreadPool::GetThreadCount() const
+{
+    return workers_.size();
+}
+
+void ThreadPool::Submit(std::function<void()> task)
+{
+    ++submitted_tasks_;
+    if (workers_.empty())
+    {
+        ++caller_executed_tasks_;
+        task();
+        return;
+    }
+
+    // The counter goes up before the task is visible, so a thief can never take it below zero
+    {
+        std::lock_guard guard(mutex_);
+        ++queued_tasks_;
+    }
+    const size_t worker_index = GetCurrentWorker();
+    if (worker_index != NO_WORKER)
+    {
+        Worker& worker = *workers_[worker_index];
+        std::lock_guard guard(worker.mutex);
+        worker.tasks.push_back(std::move(task));
+    }
+    else
+    {
+        std::lock_guard guard(mutex_);
+        shared_tasks_.push_back(std::move(task));
+    }
+    wake_up_.notify_one();
+}
+
+ThreadPool::Stats ThreadPool::GetStats() const
+{
+    Stats stats;
+    for (const auto& worker : workers_)
+    {
+        stats.workers.push_back({
+            worker->executed_tasks.load(std::memory_order_relaxed),
+            worker->stolen_tasks.load(std::memory_order_relaxed),
+            std::chrono::nanoseconds(worker->busy_ns.load(std::memory_order_relaxed)) });
+    }
+    stats.submitted_tasks = submitted_tasks_.load(std::memory_order_relaxed);
+    stats.caller_executed_tasks = caller_executed_tasks_.load(std::memory_order_relaxed);
+    stats.uptime = std::chrono::steady_clock::now() - start_time_;
+    return stats;
+}
+
+size_t ThreadPool::GetCurrentWorker() const
+{
+    return current_pool == this ? current_worker_index : NO_WORKER;
+}
+
+bool ThreadPool::PopTask(size_t worker_index, Task& task, bool& stolen)
+{
+    if (worker_index != NO_WORKER)
+    {
+        Worker& worker = *workers_[worker_index];
+        std::lock_guard guard(worker.mutex);
+        if (!worker.tasks.empty())
+        {
+            task = std::move(worker.tasks.back());
+            worker.tasks.pop_back();
+            --queued_tasks_;
+            return true;
+        }
+    }
+    {
+        std::lock_guard guard(mutex_);
+        if (!shared_tasks_.empty())
+        {
+            task = std::move(shared_tasks_.front());
+            shared_tasks_.pop_front();
+            --queued_tasks_;
+            return true;
+        }
+    }
+    const size_t first_victim = worker_index == NO_WORKER ? 0 : worker_index + 1;
+    for (size_t i = 0; i < workers_.size(); ++i)
+    {
+        const size_t victim_index = (first_victim + i) % workers_.size();
+        if (victim_index == worker_index)
+        {
+            continue;
+        }
+        Worker& victim = *workers_[victim_index];
+        std::lock_guard guard(victim.mutex);
+        if (!victim.tasks.empty())
+        {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            --queued_tasks_;
+            stolen = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ThreadPool::TryRunTask()
+{
+    const size_t worker_index = GetCurrentWorker();
+    Task task;
+    bool stolen = false;
+    if (!PopTask(worker_index, task, stolen))
+    {
+        return false;
+    }
+    task();
+    // A worker helps only from inside another task, whose busy time already covers this one
+    if (worker_index == NO_WORKER)
+    {
+        ++caller_executed_tasks_;
+    }
+    else
+    {
+        ++workers_[worker_index]->executed_tasks;
+        if (stolen)
+        {
+            ++workers_[worker_index]->stolen_tasks;
+        }
+    }
+    return true;
+}
+
+void ThreadPool::RunWorker(size_t worker_index)
+{
+    current_pool = this;
+    current_worker_index = worker_index;
+    Worker& worker = *workers_[worker_index];
+    while (true)
+    {
+        Task task;
+        bool stolen = false;
+        if (PopTask(worker_index, task, stolen))
+        {
+            const auto start_time = std::chrono::steady_clock::now();
+            task();
+            worker.busy_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time).count();
+            ++worker.executed_tasks;
+            if (stolen)
+            {
+                ++worker.stolen_tasks;
+            }
+            continue;
+        }
+
+        std::unique_lock lock(mutex_);
+        wake_up_.wait(lock, [this] { return stopping_ || queued_tasks_ > 0; });
+        if (stopping_ && queued_tasks_ == 0)
+        {
+            return;
+        }
+    }
+}
@@ -0,0 +1,178 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Work-stealing pool. Every worker has its own deque: it pushes and pops tasks at the back
+// and idle workers steal from the front. Tasks submitted from outside go to a shared queue.
+// A thread waiting for ParallelFor executes pending tasks instead of blocking, so nested
+// parallel calls neither deadlock nor start more threads than the pool has; once no task
+// is pending it sleeps until its own chunks, all running elsewhere, are done.
+class ThreadPool
+{
+public:
+    struct WorkerStats
+    {
+        uint64_t executed_tasks = 0;
+        uint64_t stolen_tasks = 0;
+        std::chrono::nanoseconds busy_time{};
+    };
+
+    struct Stats
+    {
+        std::vector<WorkerStats> workers;
+        uint64_t submitted_tasks = 0;
+        // Tasks executed by threads outside the pool while they waited for their own tasks
+        uint64_t caller_executed_tasks = 0;
+        std::chrono::nanoseconds uptime{};
+
+        // Share of the worker time spent in tasks, in [0, 1]
+        double GetUtilization() const;
+    };
+
+    // With no threads every task runs on the calling thread
+    explicit ThreadPool(size_t thread_count, bool pin_threads = false);
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Finishes the queued tasks before the workers stop
+    ~ThreadPool();
+
+    size_t GetThreadCount() const;
+
+    // Tasks must not throw, Async and ParallelFor pass exceptions to the caller
+    void Submit(std::function<void()> task);
+
+    template <typename Function>
+    std::future<std::invoke_result_t<Function>> Async(Function function);
+
+    // Calls function(i) for every i in [begin, end) and returns when all calls are done
+    template <typename Function>
+    void ParallelFor(size_t begin, size_t end, Function function);
+
+    Stats GetStats() const;
+
+private:
+    using Task = std::function<void()>;
+
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::thread thread;
+        std::atomic<uint64_t> executed_tasks = 0;
+        std::atomic<uint64_t> stolen_tasks = 0;
+        std::atomic<int64_t> busy_ns = 0;
+    };
+
+    static constexpr size_t NO_WORKER = static_cast<size_t>(-1);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::mutex mutex_;
+    std::condition_variable wake_up_;
+    std::deque<Task> shared_tasks_;
+    std::atomic<size_t> queued_tasks_ = 0;
+    std::atomic<uint64_t> submitted_tasks_ = 0;
+    std::atomic<uint64_t> caller_executed_tasks_ = 0;
+    bool stopping_ = false;
+    const std::chrono::steady_clock::time_point start_time_ = std::chrono::steady_clock::now();
+
+    // Index of the current thread in this pool or NO_WORKER
+    size_t GetCurrentWorker() const;
+
+    bool PopTask(size_t worker_index, Task& task, bool& stolen);
+
+    // Runs one queued task on the current thread, returns false if there was none
+    bool TryRunTask();
+
+    void RunWorker(size_t worker_index);
+};
+
+template <typename Function>
+std::future<std::invoke_result_t<Function>> ThreadPool::Async(Function function)
+{
+    auto task = std::make_shared<std::packaged_task<std::invoke_result_t<Function>()>>(std::move(function));
+    auto future = task->get_future();
+    Submit([task] { (*task)(); });
+    return future;
+}
+
+template <typename Function>
+void ThreadPool::ParallelFor(size_t begin, size_t end, Function function)
+{
+    const size_t count = end > begin ? end - begin : 0;
+    if (workers_.empty() || count < 2)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            function(i);
+        }
+        return;
+    }
+
+    // A few chunks per thread leave room for stealing when the chunks are uneven
+    const size_t chunk_count = std::min(count, (workers_.size() + 1) * 4);
+    // Guarded by done_mutex; notified under the lock, so the waiter can't return and destroy them in between
+    size_t remaining_chunks = chunk_count;
+    std::mutex done_mutex;
+    std::condition_variable chunk_done;
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    auto run_chunk = [&](size_t chunk)
+    {
+        try
+        {
+            for (size_t i = begin + count * chunk / chunk_count; i < begin + count * (chunk + 1) / chunk_count; ++i)
+            {
+                function(i);
+            }
+        }
+        catch (...)
+        {
+            std::lock_guard guard(error_mutex);
+            if (!error)
+            {
+                error = std::current_exception();
+            }
+        }
+        std::lock_guard guard(done_mutex);
+        if (--remaining_chunks == 0)
+        {
+            chunk_done.notify_all();
+        }
+    };
+
+    for (size_t chunk = 1; chunk < chunk_count; ++chunk)
+    {
+        Submit([&run_chunk, chunk] { run_chunk(chunk); });
+    }
+    run_chunk(0);
+    std::unique_lock lock(done_mutex);
+    while (remaining_chunks > 0)
+    {
+        lock.unlock();
+        const bool ran_task = TryRunTask();
+        lock.lock();
+        if (!ran_task)
+        {
+            // The chunks left are all running on other threads: sleep until they finish instead of spinning
+            chunk_done.wait(lock, [&remaining_chunks] { return remaining_chunks == 0; });
+        }
+    }
+    lock.unlock();
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
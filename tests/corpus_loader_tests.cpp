@@ -0,0 +1,167 @@
+// Corpus files: SplitIntoChunks cuts only after whole lines, ParseCorpusRecord rejects malformed records,
+// and LoadCorpus (seq and par, over many chunks) builds the index AddDocument does.
+// Build from the repository root:
+//     g++ -std=c++17 -O2 -I search-server -I tests tests/corpus_loader_tests.cpp $(ls search-server/*.cpp | grep -v main.cpp) -ltbb -lpthread -o corpus_loader_tests
+
+#include "corpus_loader.h"
+#include "search_server.h"
+#include "test_helpers.h"
+
+#include <execution>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    string JoinChunks(const vector<string_view>& chunks)
+    {
+        string text;
+        for (const string_view chunk : chunks)
+        {
+            text += chunk;
+        }
+        return text;
+    }
+
+    void CheckChunks(const string& text, size_t chunk_size)
+    {
+        const vector<string_view> chunks = SplitIntoChunks(text, chunk_size);
+        CHECK(JoinChunks(chunks) == text);
+        bool is_cut_right = true;
+        for (size_t i = 0; i < chunks.size(); ++i)
+        {
+            is_cut_right &= !chunks[i].empty();
+            if (i + 1 < chunks.size())
+            {
+                // Only the last chunk may be short or end without a line break
+                is_cut_right &= chunks[i].size() >= chunk_size && chunks[i].back() == '\n';
+                // The chunk ends at the first line break that reaches chunk_size
+                is_cut_right &= chunks[i].find('\n', chunk_size - 1) == chunks[i].size() - 1;
+            }
+        }
+        CHECK(is_cut_right);
+    }
+
+    void TestSplitIntoChunks()
+    {
+        CHECK(SplitIntoChunks(""sv, 10).empty());
+        CHECK((SplitIntoChunks("abc"sv, 10) == vector<string_view>{ "abc"sv }));
+        CHECK((SplitIntoChunks("a\nb\nc"sv, 1) == vector<string_view>{ "a\n"sv, "b\n"sv, "c"sv }));
+        // A line break right at the end of the chunk size ends the chunk there
+        CHECK((SplitIntoChunks("abcd\nefgh\n"sv, 5) == vector<string_view>{ "abcd\n"sv, "efgh\n"sv }));
+        CHECK((SplitIntoChunks("abcde\nf\n"sv, 5) == vector<string_view>{ "abcde\n"sv, "f\n"sv }));
+        // A line longer than the chunk size stays whole
+        CHECK((SplitIntoChunks("abcdefghij\nk"sv, 3) == vector<string_view>{ "abcdefghij\n"sv, "k"sv }));
+        CHECK((SplitIntoChunks("\n\n\n"sv, 1) == vector<string_view>{ "\n"sv, "\n"sv, "\n"sv }));
+
+        string text;
+        for (int i = 0; i < 500; ++i)
+        {
+            text += string(i % 37, 'x') + (i % 3 == 0 ? "\r\n"s : "\n"s);
+        }
+        for (const size_t chunk_size : { 1, 2, 17, 100, 1000, 100000 })
+        {
+            CheckChunks(text, chunk_size);
+            CheckChunks(text + "tail"s, chunk_size);
+        }
+    }
+
+    void TestSplitIntoLines()
+    {
+        CHECK((SplitIntoLines("a\r\n\nb\r\n\r\nc"sv) == vector<string_view>{ "a"sv, "b"sv, "c"sv }));
+        CHECK(SplitIntoLines("\n\r\n"sv).empty());
+    }
+
+    void TestParseCorpusRecord()
+    {
+        const CorpusRecord record = ParseCorpusRecord("42\tBANNED\t1 -2 3\twhite cat\tand collar"sv);
+        CHECK(record.id == 42 && record.status == DocumentStatus::BANNED);
+        CHECK((record.ratings == vector<int>{ 1, -2, 3 }));
+        // Tabs after the third one belong to the text
+        CHECK(record.text == "white cat\tand collar"sv);
+
+        const CorpusRecord no_ratings = ParseCorpusRecord("7\tREMOVED\t\t"sv);
+        CHECK(no_ratings.ratings.empty() && no_ratings.text.empty() && no_ratings.status == DocumentStatus::REMOVED);
+
+        for (const string_view line : { "1\tACTUAL\t5"sv, "1\tACTUAL"sv, "1"sv, ""sv,
+                 "x\tACTUAL\t5\ttext"sv, "1x\tACTUAL\t5\ttext"sv, "\tACTUAL\t5\ttext"sv, "99999999999\tACTUAL\t5\ttext"sv,
+                 "1\tactual\t5\ttext"sv, "1\tDELETED\t5\ttext"sv, "1\tACTUAL\t5 y\ttext"sv, "1\tACTUAL\t+5\ttext"sv })
+        {
+            CHECK(Throws<invalid_argument>([line] { ParseCorpusRecord(line); }));
+        }
+        CHECK(Throws<invalid_argument>([] { ParseCorpusRecords("1\tACTUAL\t5\tgood\n2\tACTUAL\n"sv); }));
+    }
+
+    // Copies of the test corpus under different ids, enough for several chunks
+    constexpr int COPY_COUNT = 6;
+    constexpr int COPY_ID_STEP = 1000000;
+
+    void TestLoadCorpus(const TestCorpus& test_corpus)
+    {
+        ostringstream out;
+        SearchServer expected(test_corpus.corpus.stop_words, MakeServerOptions(2));
+        for (int copy = 0; copy < COPY_COUNT; ++copy)
+        {
+            for (const SyntheticDocument& document : test_corpus.corpus.documents)
+            {
+                WriteCorpusRecord(out, document.id + copy * COPY_ID_STEP, document.status, document.ratings, document.text);
+                expected.AddDocument(document.id + copy * COPY_ID_STEP, document.text, document.status, document.ratings);
+            }
+        }
+        const string corpus = out.str();
+        CHECK(SplitIntoChunks(corpus, CORPUS_CHUNK_SIZE).size() > 2);
+
+        const vector<CorpusRecord> records = ParseCorpusRecords(corpus);
+        const size_t document_count = test_corpus.corpus.documents.size();
+        CHECK(records.size() == COPY_COUNT * document_count);
+        bool is_same = records.size() == COPY_COUNT * document_count;
+        for (size_t i = 0; is_same && i < records.size(); ++i)
+        {
+            const SyntheticDocument& document = test_corpus.corpus.documents[i % document_count];
+            is_same = records[i].id == document.id + static_cast<int>(i / document_count) * COPY_ID_STEP
+                && records[i].status == document.status && records[i].ratings == document.ratings && records[i].text == document.text;
+        }
+        CHECK(is_same);
+
+        SearchServer seq_server(test_corpus.corpus.stop_words, MakeServerOptions(2));
+        SearchServer par_server(test_corpus.corpus.stop_words, MakeServerOptions(4));
+        CHECK(LoadCorpus(execution::seq, seq_server, corpus) == records.size());
+        CHECK(LoadCorpus(execution::par, par_server, corpus) == records.size());
+        for (const SearchServer* search_server : { &seq_server, &par_server })
+        {
+            CHECK(vector<int>(search_server->begin(), search_server->end()) == vector<int>(expected.begin(), expected.end()));
+            for (const string& query : test_corpus.queries)
+            {
+                CHECK(IsSameRanking(search_server->FindTopDocuments(execution::seq, query), expected.FindTopDocuments(execution::seq, query), 0.0));
+            }
+        }
+
+        // A bad record stops the load; the chunks before it are added, in the corpus order
+        const string broken = corpus + "broken record\n"s + corpus;
+        SearchServer broken_server(test_corpus.corpus.stop_words, MakeServerOptions(4));
+        CHECK(Throws<invalid_argument>([&] { LoadCorpus(execution::par, broken_server, broken); }));
+        CHECK(broken_server.GetDocumentCount() > 0 && broken_server.GetDocumentCount() <= expected.GetDocumentCount());
+        CHECK(vector<int>(broken_server.begin(), broken_server.end())
+            == vector<int>(expected.begin(), next(expected.begin(), broken_server.GetDocumentCount())));
+        // Ids repeat in the second copy
+        SearchServer repeated_server(test_corpus.corpus.stop_words, MakeServerOptions(4));
+        CHECK(Throws<invalid_argument>([&] { LoadCorpus(execution::par, repeated_server, corpus + corpus); }));
+        CHECK(repeated_server.GetDocumentCount() == expected.GetDocumentCount());
+    }
+}
+
+int main()
+{
+    TestSplitIntoChunks();
+    TestSplitIntoLines();
+    TestParseCorpusRecord();
+    const TestCorpus test_corpus = MakeTestCorpus();
+    TestLoadCorpus(test_corpus);
+    return ReportChecks();
+}
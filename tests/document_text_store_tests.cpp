@@ -0,0 +1,237 @@
+// Document texts: the block coder round-trips any data and rejects damaged input, every TextRetention keeps
+// the texts it should through additions, replacements, removals and compactions, and GetDocumentText returns them.
+// Build from the repository root:
+//     g++ -std=c++17 -O2 -I search-server -I tests tests/document_text_store_tests.cpp $(ls search-server/*.cpp | grep -v main.cpp) -ltbb -lpthread -o document_text_store_tests
+
+#include "block_compression.h"
+#include "document_text_store.h"
+#include "search_server.h"
+#include "test_helpers.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    void CheckBlockRoundTrip(const string& data)
+    {
+        const string compressed = CompressBlock(data);
+        CHECK(DecompressBlock(compressed, data.size()) == data);
+        // Worst case: literals only, a length byte per 255 of them
+        CHECK(compressed.size() <= data.size() + data.size() / 255 + 16);
+    }
+
+    void TestBlockCompression()
+    {
+        mt19937 random(11);
+        CheckBlockRoundTrip(""s);
+        CheckBlockRoundTrip("a"s);
+        CheckBlockRoundTrip("abcd"s);
+        for (const size_t size : { size_t{ 15 }, size_t{ 16 }, size_t{ 300 }, size_t{ 65535 }, size_t{ 65536 }, size_t{ 200000 } })
+        {
+            string incompressible(size, '\0');
+            for (char& c : incompressible)
+            {
+                c = static_cast<char>(random());
+            }
+            CheckBlockRoundTrip(incompressible);
+
+            const string run(size, 'x');
+            CheckBlockRoundTrip(run);
+            if (size >= 65536)
+            {
+                CHECK(CompressBlock(run).size() < size / 100);
+            }
+
+            // Short periods: matches that overlap the bytes they produce
+            string periodic(size, '\0');
+            for (size_t i = 0; i < size; ++i)
+            {
+                periodic[i] = "ab"[i % 2];
+            }
+            CheckBlockRoundTrip(periodic);
+
+            string words;
+            while (words.size() < size)
+            {
+                words += "word"s + to_string(random() % 50) + ' ';
+            }
+            CheckBlockRoundTrip(words);
+        }
+
+        const string data(1000, 'y');
+        const string compressed = CompressBlock(data);
+        for (const size_t raw_size : { data.size() - 1, data.size() + 1 })
+        {
+            CHECK(Throws<runtime_error>([&] { DecompressBlock(compressed, raw_size); }));
+        }
+        CHECK(Throws<runtime_error>([&] { DecompressBlock(compressed.substr(0, compressed.size() / 2), data.size()); }));
+    }
+
+    string MakeText(mt19937& random, size_t size)
+    {
+        string text;
+        while (text.size() < size)
+        {
+            text += "word"s + to_string(random() % 200) + ' ';
+        }
+        text.resize(size);
+        return text;
+    }
+
+    void CheckStoredTexts(const DocumentTextStore& store, const map<int, string>& texts)
+    {
+        bool is_same = true;
+        for (const auto& [document_id, text] : texts)
+        {
+            is_same &= store.Get(document_id) == text;
+        }
+        CHECK(is_same);
+    }
+
+    // The compressed cache holds a few blocks, readers on several threads evict each other's
+    void CheckConcurrentReads(const DocumentTextStore& store, const map<int, string>& texts)
+    {
+        vector<thread> readers;
+        vector<char> is_same(4, 1);
+        for (size_t reader = 0; reader < is_same.size(); ++reader)
+        {
+            readers.emplace_back([&, reader]
+                {
+                    for (int round = 0; round < 2; ++round)
+                    {
+                        for (auto it = texts.rbegin(); it != texts.rend(); ++it)
+                        {
+                            is_same[reader] &= store.Get(it->first) == it->second;
+                        }
+                    }
+                });
+        }
+        for (thread& reader : readers)
+        {
+            reader.join();
+        }
+        CHECK(count(is_same.begin(), is_same.end(), 0) == 0);
+    }
+
+    void TestTextStore(TextRetention retention)
+    {
+        mt19937 random(42);
+        DocumentTextStore store(retention, ""s);
+        map<int, string> texts;
+        // Empty texts, texts longer than a block and texts that cross a block boundary
+        for (int document_id = 0; document_id < 3000; ++document_id)
+        {
+            const size_t size = document_id % 500 == 7 ? DocumentTextStore::BLOCK_SIZE * 2 + 5 : random() % 300;
+            texts[document_id] = MakeText(random, size);
+            store.Add(document_id, texts[document_id]);
+        }
+        CheckStoredTexts(store, texts);
+        CheckConcurrentReads(store, texts);
+        CHECK(Throws<out_of_range>([&] { store.Get(3000); }));
+
+        texts[5] = "replaced text"s;
+        store.Add(5, texts[5]);
+        CheckStoredTexts(store, texts);
+
+        // Removing nine texts in ten compacts the memory stores
+        const size_t full_bytes = store.GetMemoryBytes();
+        for (int document_id = 0; document_id < 3000; ++document_id)
+        {
+            if (document_id % 10 != 0)
+            {
+                store.Remove(document_id);
+                texts.erase(document_id);
+            }
+        }
+        store.Remove(-1);
+        CheckStoredTexts(store, texts);
+        CHECK(Throws<out_of_range>([&] { store.Get(1); }));
+        CHECK(store.GetMemoryBytes() < full_bytes / 2);
+        CheckConcurrentReads(store, texts);
+    }
+
+    void TestTextStores()
+    {
+        for (const TextRetention retention : { TextRetention::PLAIN, TextRetention::COMPRESSED, TextRetention::MAPPED_FILE })
+        {
+            TestTextStore(retention);
+        }
+
+        DocumentTextStore none(TextRetention::NONE, ""s);
+        none.Add(1, "text"s);
+        CHECK(Throws<logic_error>([&] { none.Get(1); }));
+        CHECK(none.GetFilePath().empty());
+
+        // Every mapped store has its own file in the directory it was given, deleted with the store
+        const filesystem::path directory = filesystem::temp_directory_path();
+        string first_path;
+        {
+            DocumentTextStore first(TextRetention::MAPPED_FILE, directory.string());
+            DocumentTextStore second(TextRetention::MAPPED_FILE, directory.string());
+            first_path = first.GetFilePath();
+            CHECK(first_path != second.GetFilePath());
+            CHECK(filesystem::path(first_path).parent_path() == directory);
+            CHECK(filesystem::exists(first_path) && filesystem::exists(second.GetFilePath()));
+        }
+        CHECK(!filesystem::exists(first_path));
+        CHECK(Throws<runtime_error>([] { DocumentTextStore(TextRetention::MAPPED_FILE, "/no/such/directory"s); }));
+    }
+
+    void TestDocumentText(const TestCorpus& test_corpus)
+    {
+        for (const TextRetention retention : { TextRetention::PLAIN, TextRetention::COMPRESSED, TextRetention::MAPPED_FILE })
+        {
+            SearchServerOptions options = MakeServerOptions(2);
+            options.text_retention = retention;
+            SearchServer search_server(test_corpus.corpus.stop_words, options);
+            AddDocuments(search_server, test_corpus.corpus);
+            vector<int> removed_ids;
+            for (const SyntheticDocument& document : test_corpus.corpus.documents)
+            {
+                if (IsRemoved(document.id))
+                {
+                    removed_ids.push_back(document.id);
+                }
+            }
+            search_server.RemoveDocuments(removed_ids);
+            bool is_same = true;
+            for (const SyntheticDocument& document : test_corpus.corpus.documents)
+            {
+                if (IsRemoved(document.id))
+                {
+                    CHECK(Throws<out_of_range>([&] { search_server.GetDocumentText(document.id); }));
+                }
+                else
+                {
+                    is_same &= search_server.GetDocumentText(document.id) == document.text;
+                }
+            }
+            CHECK(is_same);
+        }
+
+        SearchServerOptions options = MakeServerOptions(2);
+        options.text_retention = TextRetention::NONE;
+        SearchServer search_server(test_corpus.corpus.stop_words, options);
+        search_server.AddDocument(1, "white cat"s, DocumentStatus::ACTUAL, { 1 });
+        CHECK(search_server.FindTopDocuments("cat"s).size() == 1);
+        CHECK(Throws<logic_error>([&] { search_server.GetDocumentText(1); }));
+    }
+}
+
+int main()
+{
+    TestBlockCompression();
+    TestTextStores();
+    const TestCorpus test_corpus = MakeTestCorpus();
+    TestDocumentText(test_corpus);
+    return ReportChecks();
+}
@@ -0,0 +1,111 @@
+// ImpactList orders postings by term frequency under block bounds, and FindTopDocumentsByImpact returns what
+// FindTopDocuments does, with and without the impact index and after removals.
+// Build from the repository root:
+//     g++ -std=c++17 -O2 -I search-server -I tests tests/impact_index_tests.cpp $(ls search-server/*.cpp | grep -v main.cpp) -ltbb -lpthread -o impact_index_tests
+
+#include "impact_index.h"
+#include "posting_list.h"
+#include "search_server.h"
+#include "test_helpers.h"
+
+#include <algorithm>
+#include <execution>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    void TestImpactList()
+    {
+        PostingList postings;
+        map<int, double> expected;
+        for (int document_id = 0; document_id < 1000; ++document_id)
+        {
+            const uint32_t word_count = 1 + static_cast<uint32_t>(document_id * 7919 % 13);
+            postings.Insert(document_id * 3, word_count, 20);
+            expected[document_id * 3] = word_count / 20.0;
+        }
+        const ImpactList list("word"s, postings);
+        CHECK(list.GetWord() == "word"s);
+        CHECK(list.GetBlockCount() == (expected.size() + ImpactList::BLOCK_SIZE - 1) / ImpactList::BLOCK_SIZE);
+
+        map<int, double> listed;
+        double previous_freq = expected.begin()->second * 100;
+        bool is_ordered = true;
+        for (size_t block_index = 0; block_index < list.GetBlockCount(); ++block_index)
+        {
+            const double bound = list.GetBlockBound(block_index);
+            list.ForEachInBlock(block_index,
+                [&](int document_id, double term_freq)
+                {
+                    is_ordered &= term_freq <= bound && term_freq <= previous_freq;
+                    previous_freq = term_freq;
+                    listed[document_id] = term_freq;
+                });
+        }
+        CHECK(is_ordered);
+        CHECK(listed == expected);
+        CHECK(list.GetMemoryBytes() >= expected.size() * (sizeof(int) + sizeof(double)));
+
+        ImpactIndex impact_index;
+        CHECK(impact_index.Find(postings) == nullptr);
+        impact_index.AddTerm("word"s, postings);
+        CHECK(impact_index.Find(postings) != nullptr && impact_index.Find(postings)->GetWord() == "word"s);
+        CHECK(impact_index.GetMemoryBytes() > list.GetMemoryBytes());
+    }
+
+    void TestImpactSearch(const TestCorpus& test_corpus)
+    {
+        SearchServer search_server(test_corpus.corpus.stop_words, MakeServerOptions(2));
+        AddDocuments(search_server, test_corpus.corpus);
+        auto even_ids = [](int document_id, DocumentStatus status, int rating) { return document_id % 2 == 0; };
+        for (const bool removed : { false, true })
+        {
+            if (removed)
+            {
+                vector<int> removed_ids;
+                for (const SyntheticDocument& document : test_corpus.corpus.documents)
+                {
+                    if (IsRemoved(document.id))
+                    {
+                        removed_ids.push_back(document.id);
+                    }
+                }
+                search_server.RemoveDocuments(removed_ids);
+            }
+            // Without the index the search falls back to FindTopDocuments
+            CHECK(!search_server.HasImpactIndex());
+            CHECK(IsSameRanking(search_server.FindTopDocumentsByImpact(test_corpus.queries.front()),
+                search_server.FindTopDocuments(execution::seq, test_corpus.queries.front()), 0.0));
+            search_server.BuildImpactIndex();
+            CHECK(search_server.HasImpactIndex());
+            for (const string& query : test_corpus.queries)
+            {
+                const vector<Document> expected = search_server.FindTopDocuments(execution::seq, query);
+                // Relevances are summed in the same order, bit for bit
+                CHECK(IsSameRanking(search_server.FindTopDocumentsByImpact(query), expected, 0.0));
+                // The par sums are taken in the order the threads run
+                CHECK(IsSameRanking(search_server.FindTopDocuments(execution::par, query), expected, 1e-9));
+                CHECK(IsSameRanking(search_server.FindTopDocumentsByImpact(query, DocumentStatus::BANNED),
+                    search_server.FindTopDocuments(execution::seq, query, DocumentStatus::BANNED), 0.0));
+                CHECK(IsSameRanking(search_server.FindTopDocumentsByImpact(query, even_ids),
+                    search_server.FindTopDocuments(execution::seq, query, even_ids), 0.0));
+            }
+        }
+        // Any change to the documents drops the index
+        const SyntheticDocument& document = test_corpus.corpus.documents[2];
+        search_server.AddDocument(document.id, document.text, document.status, document.ratings);
+        CHECK(!search_server.HasImpactIndex());
+    }
+}
+
+int main()
+{
+    TestImpactList();
+    const TestCorpus test_corpus = MakeTestCorpus();
+    TestImpactSearch(test_corpus);
+    return ReportChecks();
+}
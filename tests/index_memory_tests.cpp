@@ -0,0 +1,170 @@
+// Allocation modes of the index: servers on the global heap, pools and arenas (with and without huge pages)
+// hold the same documents and rank them the same way through additions and removals; GetMemoryUsage reports
+// the memory pools and arenas take from the system.
+// Build from the repository root:
+//     g++ -std=c++17 -O2 -I search-server -I tests tests/index_memory_tests.cpp $(ls search-server/*.cpp | grep -v main.cpp) -ltbb -lpthread -o index_memory_tests
+
+#include "index_memory.h"
+#include "memory_usage.h"
+#include "search_server.h"
+#include "test_helpers.h"
+
+#include <execution>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    using WordMap = map<string_view, double>;
+
+    struct AllocationMode
+    {
+        IndexAllocation allocation;
+        bool use_huge_pages;
+    };
+
+    const vector<AllocationMode> ALLOCATION_MODES = {
+        { IndexAllocation::GLOBAL_HEAP, false },
+        { IndexAllocation::POOL, false },
+        { IndexAllocation::ARENA, false },
+        { IndexAllocation::ARENA, true },
+    };
+
+    unique_ptr<SearchServer> MakeServer(const TestCorpus& test_corpus, const AllocationMode& mode)
+    {
+        SearchServerOptions options = MakeServerOptions(2);
+        options.allocation = mode.allocation;
+        options.use_huge_pages = mode.use_huge_pages;
+        return make_unique<SearchServer>(test_corpus.corpus.stop_words, options);
+    }
+
+    void AddDocuments(SearchServer& search_server, const SyntheticCorpus& corpus, bool removed)
+    {
+        for (const SyntheticDocument& document : corpus.documents)
+        {
+            if (IsRemoved(document.id) == removed)
+            {
+                search_server.AddDocument(document.id, document.text, document.status, document.ratings);
+            }
+        }
+    }
+
+    void CheckSameIndex(const SearchServer& search_server, const SearchServer& reference, const vector<string>& queries)
+    {
+        CHECK(vector<int>(search_server.begin(), search_server.end()) == vector<int>(reference.begin(), reference.end()));
+        CHECK(search_server.GetDocumentCount() == reference.GetDocumentCount());
+        for (const int document_id : search_server)
+        {
+            CHECK(WordMap(search_server.GetWordFrequencies(document_id))
+                == WordMap(reference.GetWordFrequencies(document_id)));
+        }
+        for (const string& query : queries)
+        {
+            CHECK(IsSameRanking(search_server.FindTopDocuments(execution::seq, query),
+                reference.FindTopDocuments(execution::seq, query), 0.0));
+        }
+    }
+
+    void TestWordFrequencies(const SearchServer& search_server)
+    {
+        for (const int document_id : search_server)
+        {
+            const SearchServer::WordFrequencies word_freqs = search_server.GetWordFrequencies(document_id);
+            const WordMap copy = word_freqs;
+            CHECK(copy.size() == word_freqs.size() && !word_freqs.empty());
+            CHECK(WordMap(word_freqs.begin(), word_freqs.end()) == copy);
+            const auto& [word, freq] = *word_freqs.begin();
+            CHECK(word_freqs.count(word) == 1 && word_freqs.find(word) == word_freqs.begin() && word_freqs.at(word) == freq);
+            CHECK(word_freqs.count("no-such-word"sv) == 0 && word_freqs.find("no-such-word"sv) == word_freqs.end());
+            CHECK(Throws<out_of_range>([&] { word_freqs.at("no-such-word"sv); }));
+        }
+        CHECK(Throws<out_of_range>([&] { search_server.GetWordFrequencies(-1); }));
+    }
+
+    void TestAllocationModes(const TestCorpus& test_corpus)
+    {
+        const unique_ptr<SearchServer> all_documents = MakeServer(test_corpus, ALLOCATION_MODES.front());
+        AddDocuments(*all_documents, test_corpus.corpus);
+        const unique_ptr<SearchServer> kept_documents = MakeServer(test_corpus, ALLOCATION_MODES.front());
+        AddDocuments(*kept_documents, test_corpus.corpus, false);
+
+        for (const AllocationMode& mode : ALLOCATION_MODES)
+        {
+            const unique_ptr<SearchServer> search_server = MakeServer(test_corpus, mode);
+            AddDocuments(*search_server, test_corpus.corpus);
+            CheckSameIndex(*search_server, *all_documents, test_corpus.queries);
+            TestWordFrequencies(*search_server);
+
+            for (const SyntheticDocument& document : test_corpus.corpus.documents)
+            {
+                if (IsRemoved(document.id))
+                {
+                    search_server->RemoveDocument(document.id);
+                }
+            }
+            CheckSameIndex(*search_server, *kept_documents, test_corpus.queries);
+
+            // Added again into the memory the removals freed, or next to it in an arena
+            AddDocuments(*search_server, test_corpus.corpus, true);
+            CheckSameIndex(*search_server, *all_documents, test_corpus.queries);
+        }
+    }
+
+    size_t GetIndexBytes(const MemoryUsage& usage)
+    {
+        return usage.postings + usage.forward_index + usage.document_metadata + usage.index_resource;
+    }
+
+    void TestReservedMemory(const TestCorpus& test_corpus)
+    {
+        const unique_ptr<SearchServer> heap_server = MakeServer(test_corpus, ALLOCATION_MODES.front());
+        AddDocuments(*heap_server, test_corpus.corpus);
+        const MemoryUsage heap_usage = heap_server->GetMemoryUsage();
+        CHECK(heap_usage.index_resource == 0);
+
+        for (const AllocationMode& mode : ALLOCATION_MODES)
+        {
+            if (mode.allocation == IndexAllocation::GLOBAL_HEAP)
+            {
+                continue;
+            }
+            const unique_ptr<SearchServer> search_server = MakeServer(test_corpus, mode);
+            const size_t empty_bytes = search_server->GetMemoryUsage().index_resource;
+            AddDocuments(*search_server, test_corpus.corpus);
+            const MemoryUsage full = search_server->GetMemoryUsage();
+            CHECK(full.postings == 0 && full.forward_index == 0 && full.document_metadata == 0);
+            CHECK(full.index_resource > empty_bytes);
+            CHECK(full.stop_words == heap_usage.stop_words && full.dictionary == heap_usage.dictionary);
+            CHECK(full.GetTotal() == full.stop_words + full.dictionary + full.document_text + full.impact_index + full.index_resource);
+            // Pool blocks have no headers, but pools and arenas keep free memory in reserve
+            CHECK(full.index_resource > GetIndexBytes(heap_usage) / 2 && full.index_resource < GetIndexBytes(heap_usage) * 3);
+
+            for (const SyntheticDocument& document : test_corpus.corpus.documents)
+            {
+                search_server->RemoveDocument(document.id);
+            }
+            // The arena returns nothing to the system before it is destroyed
+            if (mode.allocation == IndexAllocation::ARENA)
+            {
+                CHECK(search_server->GetMemoryUsage().index_resource == full.index_resource);
+            }
+            // The freed blocks are reused, not taken from the system again
+            AddDocuments(*search_server, test_corpus.corpus);
+            CHECK(search_server->GetMemoryUsage().index_resource < full.index_resource * 3 / 2);
+        }
+    }
+}
+
+int main()
+{
+    const TestCorpus test_corpus = MakeTestCorpus();
+    TestAllocationModes(test_corpus);
+    TestReservedMemory(test_corpus);
+    return ReportChecks();
+}
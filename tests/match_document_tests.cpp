@@ -0,0 +1,120 @@
+// MatchDocument and MatchDocuments against the words of the document texts, with seq and par.
+// Build from the repository root:
+//     g++ -std=c++17 -O2 -I search-server -I tests tests/match_document_tests.cpp $(ls search-server/*.cpp | grep -v main.cpp) -ltbb -lpthread -o match_document_tests
+
+#include "search_server.h"
+#include "string_processing.h"
+#include "test_helpers.h"
+
+#include <algorithm>
+#include <execution>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    using Match = tuple<vector<string_view>, DocumentStatus>;
+
+    // Plus words of the query found in the text, sorted; none if a minus word is found
+    vector<string> MatchNaively(const string& query, const string& text, const set<string, less<>>& stop_words)
+    {
+        const vector<string_view> text_words = SplitIntoWords(text);
+        const set<string_view> words(text_words.begin(), text_words.end());
+        set<string> matched;
+        for (string_view word : SplitIntoWords(query))
+        {
+            const bool is_minus = word[0] == '-';
+            if (is_minus)
+            {
+                word.remove_prefix(1);
+            }
+            if (stop_words.count(word) || !words.count(word))
+            {
+                continue;
+            }
+            if (is_minus)
+            {
+                return {};
+            }
+            matched.emplace(word);
+        }
+        return { matched.begin(), matched.end() };
+    }
+
+    bool IsMatch(const Match& match, const vector<string>& words, DocumentStatus status)
+    {
+        const auto& [matched_words, matched_status] = match;
+        return matched_status == status && equal(matched_words.begin(), matched_words.end(), words.begin(), words.end());
+    }
+
+    void TestSmallIndex()
+    {
+        SearchServer search_server("and in"s, MakeServerOptions(2));
+        search_server.AddDocument(1, "white cat and fashionable collar"s, DocumentStatus::ACTUAL, { 8, -3 });
+        search_server.AddDocument(2, "fluffy cat fluffy tail"s, DocumentStatus::BANNED, { 7, 2, 7 });
+        search_server.AddDocument(3, "groomed dog expressive eyes"s, DocumentStatus::IRRELEVANT, { 5, -12, 2, 1 });
+
+        CHECK(IsMatch(search_server.MatchDocument("fluffy groomed cat"s, 2), { "cat"s, "fluffy"s }, DocumentStatus::BANNED));
+        CHECK(IsMatch(search_server.MatchDocument("fluffy -cat"s, 2), {}, DocumentStatus::BANNED));
+        CHECK(IsMatch(search_server.MatchDocument(execution::par, "cat and collar"s, 1), { "cat"s, "collar"s }, DocumentStatus::ACTUAL));
+        // Stop words and unknown words match nothing, as plus and as minus words
+        CHECK(IsMatch(search_server.MatchDocument("and unknown -in -unknown dog"s, 3), { "dog"s }, DocumentStatus::IRRELEVANT));
+
+        const vector<Match> matches = search_server.MatchDocuments(execution::par, "cat -tail"s, { 3, 2, 1, 1 });
+        CHECK(matches.size() == 4);
+        CHECK(IsMatch(matches[0], {}, DocumentStatus::IRRELEVANT));
+        CHECK(IsMatch(matches[1], {}, DocumentStatus::BANNED));
+        CHECK(IsMatch(matches[2], { "cat"s }, DocumentStatus::ACTUAL));
+        CHECK(IsMatch(matches[3], { "cat"s }, DocumentStatus::ACTUAL));
+        CHECK(search_server.MatchDocuments("cat"s, {}).empty());
+
+        CHECK(Throws<out_of_range>([&] { search_server.MatchDocument("cat"s, 4); }));
+        CHECK(Throws<out_of_range>([&] { search_server.MatchDocuments(execution::par, "cat"s, { 1, 4 }); }));
+        CHECK(Throws<invalid_argument>([&] { search_server.MatchDocument("cat --dog"s, 1); }));
+        CHECK(Throws<invalid_argument>([&] { search_server.MatchDocuments("cat -"s, { 1 }); }));
+
+        // Removed documents can't be matched, the words they shared with the others still can
+        search_server.RemoveDocument(2);
+        CHECK(Throws<out_of_range>([&] { search_server.MatchDocument("cat"s, 2); }));
+        CHECK(IsMatch(search_server.MatchDocument("fluffy cat"s, 1), { "cat"s }, DocumentStatus::ACTUAL));
+    }
+
+    void TestCorpusMatches(const TestCorpus& test_corpus)
+    {
+        SearchServer search_server(test_corpus.corpus.stop_words, MakeServerOptions(2));
+        AddDocuments(search_server, test_corpus.corpus);
+        const vector<string_view> stop_words_list = SplitIntoWords(test_corpus.corpus.stop_words);
+        const set<string, less<>> stop_words(stop_words_list.begin(), stop_words_list.end());
+
+        vector<int> document_ids;
+        for (size_t i = 0; i < test_corpus.corpus.documents.size(); i += 37)
+        {
+            document_ids.push_back(test_corpus.corpus.documents[i].id);
+        }
+        for (size_t i = 0; i < test_corpus.queries.size(); i += 3)
+        {
+            const string& query = test_corpus.queries[i];
+            const vector<Match> seq_matches = search_server.MatchDocuments(execution::seq, query, document_ids);
+            const vector<Match> par_matches = search_server.MatchDocuments(execution::par, query, document_ids);
+            CHECK(seq_matches.size() == document_ids.size() && par_matches == seq_matches);
+            for (size_t j = 0; j < document_ids.size() && j < seq_matches.size(); ++j)
+            {
+                const SyntheticDocument& document = test_corpus.corpus.documents[document_ids[j]];
+                CHECK(IsMatch(seq_matches[j], MatchNaively(query, document.text, stop_words), document.status));
+                CHECK(search_server.MatchDocument(query, document_ids[j]) == seq_matches[j]);
+            }
+        }
+    }
+}
+
+int main()
+{
+    TestSmallIndex();
+    TestCorpusMatches(MakeTestCorpus());
+    return ReportChecks();
+}
@@ -0,0 +1,134 @@
+// GetMemoryUsage: the estimate of every structure follows additions and removals, and with glibc
+// the total matches the heap memory the server really takes.
+// Build from the repository root:
+//     g++ -std=c++17 -O2 -I search-server -I tests tests/memory_usage_tests.cpp $(ls search-server/*.cpp | grep -v main.cpp) -ltbb -lpthread -o memory_usage_tests
+
+#include "memory_usage.h"
+#include "search_server.h"
+#include "test_helpers.h"
+
+#include <cmath>
+#include <execution>
+#include <string>
+#include <vector>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+    vector<int> GetRemovedIds(const SyntheticCorpus& corpus)
+    {
+        vector<int> removed_ids;
+        for (const SyntheticDocument& document : corpus.documents)
+        {
+            if (IsRemoved(document.id))
+            {
+                removed_ids.push_back(document.id);
+            }
+        }
+        return removed_ids;
+    }
+
+    void TestHeapHelpers()
+    {
+        CHECK(GetHeapBlockBytes(0) == 0);
+        CHECK(GetHeapBlockBytes(1) == 32);
+        CHECK(GetHeapBlockBytes(24) == 32);
+        CHECK(GetHeapBlockBytes(25) == 48);
+        CHECK(GetTreeNodeBytes<int>() == 48);
+        CHECK(GetStringHeapBytes(string(15, 'x')) == 0);
+        CHECK(GetStringHeapBytes(string(16, 'x')) == 32);
+    }
+
+    void TestMemoryBreakdown(const TestCorpus& test_corpus)
+    {
+        SearchServer search_server(test_corpus.corpus.stop_words, MakeServerOptions(2));
+        const MemoryUsage empty = search_server.GetMemoryUsage();
+        CHECK(empty.stop_words > 0);
+        CHECK(empty.postings == 0 && empty.forward_index == 0 && empty.document_metadata == 0 && empty.impact_index == 0);
+
+        AddDocuments(search_server, test_corpus.corpus);
+        const MemoryUsage full = search_server.GetMemoryUsage();
+        CHECK(full.stop_words == empty.stop_words);
+        CHECK(full.dictionary > empty.dictionary);
+        CHECK(full.postings > 0 && full.forward_index > 0 && full.document_metadata > 0);
+        size_t text_size = 0;
+        for (const SyntheticDocument& document : test_corpus.corpus.documents)
+        {
+            text_size += document.text.size();
+        }
+        CHECK(full.document_text >= text_size);
+        CHECK(full.GetTotal() == full.stop_words + full.dictionary + full.postings + full.forward_index
+            + full.document_metadata + full.document_text + full.impact_index);
+
+        search_server.BuildImpactIndex();
+        CHECK(search_server.GetMemoryUsage().impact_index > 0);
+
+        // Removing half the documents one way and the rest the other frees all the memory of the documents
+        const vector<int> removed_ids = GetRemovedIds(test_corpus.corpus);
+        search_server.RemoveDocuments(execution::par, removed_ids);
+        const MemoryUsage part = search_server.GetMemoryUsage();
+        CHECK(part.impact_index == 0);
+        CHECK(part.postings < full.postings && part.forward_index < full.forward_index && part.document_text < full.document_text);
+        CHECK(part.document_metadata == full.document_metadata / test_corpus.corpus.documents.size()
+            * (test_corpus.corpus.documents.size() - removed_ids.size()));
+        for (const SyntheticDocument& document : test_corpus.corpus.documents)
+        {
+            if (!IsRemoved(document.id))
+            {
+                search_server.RemoveDocument(document.id);
+            }
+        }
+        const MemoryUsage none = search_server.GetMemoryUsage();
+        CHECK(none.postings == 0 && none.forward_index == 0 && none.document_metadata == 0);
+        CHECK(none.dictionary < full.dictionary);
+    }
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    size_t GetHeapInUse()
+    {
+        return mallinfo2().uordblks;
+    }
+
+    bool IsClose(size_t estimate, size_t measured)
+    {
+        return abs(static_cast<double>(estimate) - static_cast<double>(measured)) <= 0.02 * static_cast<double>(measured);
+    }
+
+    // The texts are not kept, their store is the only estimate that depends on the hash table growth policy
+    void TestAgainstHeap(const TestCorpus& test_corpus)
+    {
+        SearchServerOptions options = MakeServerOptions(0);
+        options.text_retention = TextRetention::NONE;
+        const size_t heap_before = GetHeapInUse();
+        SearchServer search_server(test_corpus.corpus.stop_words, options);
+        const size_t empty_total = search_server.GetMemoryUsage().GetTotal();
+        AddDocuments(search_server, test_corpus.corpus);
+        const size_t heap_full = GetHeapInUse();
+        const size_t full_total = search_server.GetMemoryUsage().GetTotal();
+        CHECK(IsClose(full_total, heap_full - heap_before));
+
+        search_server.RemoveDocuments(GetRemovedIds(test_corpus.corpus));
+        const size_t removed_total = search_server.GetMemoryUsage().GetTotal();
+        CHECK(IsClose(full_total - removed_total, heap_full - GetHeapInUse()));
+        CHECK(empty_total < removed_total && removed_total < full_total);
+    }
+#else
+    void TestAgainstHeap(const TestCorpus& test_corpus)
+    {
+    }
+#endif
+}
+
+int main()
+{
+    TestHeapHelpers();
+    const TestCorpus test_corpus = MakeTestCorpus();
+    TestMemoryBreakdown(test_corpus);
+    TestAgainstHeap(test_corpus);
+    return ReportChecks();
+}
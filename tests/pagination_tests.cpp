@@ -0,0 +1,124 @@
+// Search-after pagination: stateless pages, cursor pages and the lazy paginator return every matched document
+// once, in the page order, and the ranking of FindTopDocuments keeps its tolerance for close relevances.
+// Build from the repository root:
+//     g++ -std=c++17 -O2 -I search-server -I tests tests/pagination_tests.cpp $(ls search-server/*.cpp | grep -v main.cpp) -ltbb -lpthread -o pagination_tests
+
+#include "paginator.h"
+#include "search_cursor.h"
+#include "search_server.h"
+#include "test_helpers.h"
+
+#include <algorithm>
+#include <execution>
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    void TestRankingTolerance()
+    {
+        // Relevances closer than COMPARISON_ACCURACY tie even across a step of the page order
+        const Document lower{ 1, 2e-6 - 1e-12, 5 };
+        const Document higher{ 2, 2e-6 + 1e-12, 3 };
+        CHECK(SearchServer::IsRankedBefore(lower, higher));
+        CHECK(!SearchServer::IsRankedBefore(higher, lower));
+        CHECK(SearchCursor::IsPagedBefore(higher, lower));
+
+        const Document same_rating{ 0, 2e-6, 5 };
+        CHECK(SearchServer::IsRankedBefore(same_rating, lower));
+        CHECK(SearchServer::IsRankedBefore(Document{ 3, 1.0, 0 }, Document{ 4, 1.0 - 2e-6, 10 }));
+
+        vector<Document> documents{ { 5, 0.5, 1 }, higher, { 7, 0.9, 0 }, lower, same_rating };
+        const vector<Document> top = SearchServer::SelectTopDocuments(documents, 3);
+        CHECK(top.size() == 3 && top[0].id == 7 && top[1].id == 5 && top[2].id == 0);
+        CHECK(SearchServer::SelectTopDocuments(documents, 10).size() == documents.size());
+    }
+
+    void TestSearchCursor()
+    {
+        vector<Document> documents;
+        for (int id = 0; id < 50; ++id)
+        {
+            documents.push_back({ id, (id % 7) * 0.1, id % 3 });
+        }
+        vector<Document> expected = documents;
+        sort(expected.begin(), expected.end(), SearchCursor::IsPagedBefore);
+
+        SearchCursor cursor(documents, nullopt);
+        CHECK(!cursor.GetLastDocument());
+        vector<Document> paged;
+        while (!cursor.IsExhausted())
+        {
+            const vector<Document> page = cursor.NextPage(8);
+            CHECK(!page.empty() && page.size() <= 8);
+            paged.insert(paged.end(), page.begin(), page.end());
+            CHECK(cursor.GetLastDocument() && cursor.GetLastDocument()->id == paged.back().id);
+        }
+        CHECK(IsSameRanking(paged, expected, 0.0));
+        CHECK(cursor.NextPage(8).empty());
+
+        // A cursor opened after a document continues right behind it
+        SearchCursor resumed(documents, expected[19]);
+        CHECK(IsSameRanking(resumed.NextPage(100), vector<Document>(expected.begin() + 20, expected.end()), 0.0));
+    }
+
+    void TestPagination(const TestCorpus& test_corpus)
+    {
+        SearchServer search_server(test_corpus.corpus.stop_words, MakeServerOptions(2));
+        AddDocuments(search_server, test_corpus.corpus);
+        for (size_t i = 0; i < test_corpus.queries.size(); i += 10)
+        {
+            const string& query = test_corpus.queries[i];
+            const vector<Document> all = search_server.FindTopDocumentsAfter(query, nullopt, test_corpus.corpus.documents.size());
+            CHECK(is_sorted(all.begin(), all.end(), SearchCursor::IsPagedBefore));
+
+            vector<Document> paged;
+            optional<Document> after;
+            for (vector<Document> page; !(page = search_server.FindTopDocumentsAfter(query, after, 7)).empty(); after = page.back())
+            {
+                CHECK(page.size() <= 7);
+                paged.insert(paged.end(), page.begin(), page.end());
+                if (paged.size() > all.size())
+                {
+                    break;
+                }
+            }
+            CHECK(IsSameRanking(paged, all, 0.0));
+
+            SearchCursor cursor = search_server.OpenSearchCursor(execution::seq, query, DocumentStatus::ACTUAL);
+            vector<Document> cursor_paged;
+            while (!cursor.IsExhausted())
+            {
+                const vector<Document> page = cursor.NextPage(7);
+                cursor_paged.insert(cursor_paged.end(), page.begin(), page.end());
+            }
+            CHECK(IsSameRanking(cursor_paged, all, 0.0));
+
+            // The par sums may differ in the last bits, and so move a document across a step of the page order
+            SearchCursor par_cursor = search_server.OpenSearchCursor(execution::par, query, DocumentStatus::ACTUAL);
+            CHECK(par_cursor.NextPage(all.size() + 1).size() == all.size());
+
+            vector<Document> lazily_paged;
+            for (const vector<Document>& page : PaginateSearch(search_server, query, 7))
+            {
+                lazily_paged.insert(lazily_paged.end(), page.begin(), page.end());
+            }
+            CHECK(IsSameRanking(lazily_paged, all, 0.0));
+
+            const vector<Document> top = search_server.FindTopDocuments(query);
+            CHECK(top.size() == min(all.size(), static_cast<size_t>(MAX_RESULT_DOCUMENT_COUNT)));
+            CHECK(is_sorted(top.begin(), top.end(), SearchServer::IsRankedBefore));
+        }
+    }
+}
+
+int main()
+{
+    TestRankingTolerance();
+    TestSearchCursor();
+    TestPagination(MakeTestCorpus());
+    return ReportChecks();
+}
@@ -0,0 +1,141 @@
+// Checks PostingList against a std::map: single and batch insertion and erasure, block decoding,
+// ids next to INT_MAX and gaps between ids wider than 2^24.
+// Build from the repository root:
+//     g++ -std=c++17 -O2 -I search-server -I tests tests/posting_list_tests.cpp $(ls search-server/*.cpp | grep -v main.cpp) -ltbb -lpthread -o posting_list_tests
+
+#include "posting_list.h"
+#include "test_helpers.h"
+
+#include <algorithm>
+#include <climits>
+#include <map>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    // Word count and document length of a posting
+    using ModelPostings = map<int, pair<uint32_t, uint32_t>>;
+
+    void CheckPostingList(const PostingList& postings, const ModelPostings& model)
+    {
+        CHECK(postings.size() == model.size());
+        CHECK(postings.empty() == model.empty());
+
+        auto expected = model.begin();
+        PostingList::DecodedBlock decoded;
+        for (size_t block_index = 0; block_index < postings.GetBlockCount(); ++block_index)
+        {
+            postings.DecodeBlock(block_index, decoded);
+            CHECK(decoded.size > 0 && decoded.size <= PostingList::BLOCK_SIZE);
+            CHECK(decoded.size == postings.GetBlockSize(block_index));
+            CHECK(decoded.document_ids[0] == postings.GetBlockFirstDocumentId(block_index));
+            CHECK(postings.LowerBoundBlock(decoded.document_ids[0]) == block_index);
+            for (size_t i = 0; i < decoded.size; ++i, ++expected)
+            {
+                if (expected == model.end())
+                {
+                    CHECK(!"more postings than in the model");
+                    return;
+                }
+                const auto& [word_count, document_length] = expected->second;
+                CHECK(decoded.document_ids[i] == expected->first);
+                CHECK(decoded.term_freqs[i] == static_cast<double>(word_count) / static_cast<double>(document_length));
+            }
+        }
+        CHECK(expected == model.end());
+
+        size_t visited = 0;
+        expected = model.begin();
+        postings.ForEach([&](int document_id, double term_freq)
+        {
+            CHECK(expected != model.end() && document_id == expected->first);
+            ++visited;
+            ++expected;
+        });
+        CHECK(visited == model.size());
+    }
+
+    // Document ids drawn from ranges that stress the encoding: dense runs that split blocks,
+    // gaps wider than 2^24 that need four bytes, and ids next to INT_MAX
+    int NextDocumentId(mt19937& random)
+    {
+        switch (random() % 3)
+        {
+        case 0:
+            return static_cast<int>(random() % 2000);
+        case 1:
+            return static_cast<int>((random() % 64) << 25) + static_cast<int>(random() % 3);
+        default:
+            return INT_MAX - static_cast<int>(random() % 1000);
+        }
+    }
+
+    void TestPostingList()
+    {
+        mt19937 random(7);
+        PostingList postings;
+        ModelPostings model;
+        for (int round = 0; round < 40; ++round)
+        {
+            for (int i = 0; i < 300; ++i)
+            {
+                const int document_id = NextDocumentId(random);
+                const uint32_t document_length = 1 + random() % 100000;
+                const uint32_t word_count = 1 + random() % document_length;
+                postings.Insert(document_id, word_count, document_length);
+                model[document_id] = { word_count, document_length };
+            }
+            CheckPostingList(postings, model);
+
+            for (int i = 0; i < 40; ++i)
+            {
+                const int document_id = NextDocumentId(random);
+                CHECK(postings.Erase(document_id) == (model.erase(document_id) > 0));
+                CHECK(!postings.Contains(document_id));
+            }
+            CheckPostingList(postings, model);
+
+            // A sorted batch mixing present and absent ids, some whole blocks among them
+            vector<int> batch;
+            for (const auto& [document_id, posting] : model)
+            {
+                if (random() % 4 == 0 || (document_id >= 500 && document_id < 800))
+                {
+                    batch.push_back(document_id);
+                }
+            }
+            for (int i = 0; i < 20; ++i)
+            {
+                batch.push_back(NextDocumentId(random));
+            }
+            sort(batch.begin(), batch.end());
+            batch.erase(unique(batch.begin(), batch.end()), batch.end());
+            size_t erased = 0;
+            for (const int document_id : batch)
+            {
+                erased += model.erase(document_id);
+            }
+            CHECK(postings.Erase(batch.cbegin(), batch.cend()) == erased);
+            CheckPostingList(postings, model);
+        }
+
+        CHECK(postings.Erase(vector<int>{}.cbegin(), vector<int>{}.cend()) == 0);
+        vector<int> all_ids;
+        for (const auto& [document_id, posting] : model)
+        {
+            all_ids.push_back(document_id);
+        }
+        CHECK(postings.Erase(all_ids.cbegin(), all_ids.cend()) == all_ids.size());
+        CheckPostingList(postings, {});
+        CHECK(postings.GetBlockCount() == 0);
+    }
+}
+
+int main()
+{
+    TestPostingList();
+    return ReportChecks();
+}
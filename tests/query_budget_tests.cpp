@@ -0,0 +1,154 @@
+// FindTopDocumentsWithin and FindTopDocumentsAsync: posting budgets down to a part of the first block,
+// deadlines, cancellation and the is_partial flag, against FindTopDocuments.
+// Build from the repository root:
+//     g++ -std=c++17 -O2 -I search-server -I tests tests/query_budget_tests.cpp $(ls search-server/*.cpp | grep -v main.cpp) -ltbb -lpthread -o query_budget_tests
+
+#include "query_budget.h"
+#include "search_server.h"
+#include "test_helpers.h"
+
+#include <chrono>
+#include <execution>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    QueryOptions MakeBudget(size_t posting_budget)
+    {
+        QueryOptions options;
+        options.posting_budget = posting_budget;
+        return options;
+    }
+
+    void TestQueryBudget()
+    {
+        CHECK(QueryBudget(MakeBudget(0)).Charge(1000) == 1000);
+
+        QueryBudget budget(MakeBudget(300));
+        CHECK(budget.Charge(128) == 128);
+        CHECK(budget.Charge(128) == 128);
+        CHECK(!budget.IsExhausted());
+        CHECK(budget.Charge(128) == 44);
+        CHECK(budget.IsExhausted());
+        CHECK(budget.Charge(1) == 0);
+        CHECK(budget.GetChargedPostings() == 300);
+
+        QueryBudget exact_budget(MakeBudget(128));
+        CHECK(exact_budget.Charge(128) == 128);
+        CHECK(!exact_budget.IsExhausted());
+        CHECK(exact_budget.Charge(1) == 0);
+        CHECK(exact_budget.IsExhausted());
+
+        // Copies of a token share the flag
+        QueryOptions cancelled;
+        CancellationToken copy = cancelled.cancellation;
+        CHECK(!cancelled.cancellation.IsCancelled());
+        copy.Cancel();
+        CHECK(cancelled.cancellation.IsCancelled());
+        QueryBudget cancelled_budget(cancelled);
+        CHECK(cancelled_budget.Charge(10) == 0 && cancelled_budget.IsExhausted());
+
+        QueryOptions expired;
+        expired.deadline = chrono::steady_clock::now() - chrono::seconds(1);
+        QueryBudget expired_budget(expired);
+        CHECK(expired_budget.Charge(10) == 0 && expired_budget.IsExhausted());
+    }
+
+    void TestBudgetWithinFirstBlock()
+    {
+        SearchServer search_server(""s, MakeServerOptions(2));
+        // "common" is in four documents of five, far more than a block
+        for (int id = 0; id < 1000; ++id)
+        {
+            search_server.AddDocument(id, (id % 5 == 4 ? "rare"s : "common"s) + " word"s + to_string(id), DocumentStatus::ACTUAL, { id % 10 });
+        }
+        const SearchResult partial = search_server.FindTopDocumentsWithin("common"s, MakeBudget(10));
+        CHECK(partial.is_partial);
+        CHECK(partial.scored_postings == 10);
+        CHECK(partial.documents.size() == MAX_RESULT_DOCUMENT_COUNT);
+        for (const Document& document : partial.documents)
+        {
+            // The first postings of the list, ids 0 to 12 without the multiples of 5 plus 4
+            CHECK(document.id < 13 && document.id % 5 != 4);
+        }
+
+        const SearchResult one = search_server.FindTopDocumentsWithin("common"s, MakeBudget(1));
+        CHECK(one.is_partial && one.scored_postings == 1 && one.documents.size() == 1 && one.documents[0].id == 0);
+
+        const SearchResult whole = search_server.FindTopDocumentsWithin("common"s, MakeBudget(800));
+        CHECK(!whole.is_partial && whole.scored_postings == 800);
+        CHECK(IsSameRanking(whole.documents, search_server.FindTopDocuments("common"s), 1e-9));
+
+        // The minus word is checked whatever the budget
+        for (const Document& document : search_server.FindTopDocumentsWithin("common -word3"s, MakeBudget(5)).documents)
+        {
+            CHECK(document.id != 3);
+        }
+    }
+
+    void TestCorpusBudgets(const TestCorpus& test_corpus)
+    {
+        SearchServer search_server(test_corpus.corpus.stop_words, MakeServerOptions(2));
+        AddDocuments(search_server, test_corpus.corpus);
+        auto odd_ids = [](int document_id, DocumentStatus status, int rating) { return document_id % 2 == 1; };
+        for (size_t i = 0; i < test_corpus.queries.size(); i += 3)
+        {
+            const string& query = test_corpus.queries[i];
+            const SearchResult unlimited = search_server.FindTopDocumentsWithin(query, QueryOptions{});
+            CHECK(!unlimited.is_partial);
+            CHECK(IsSameRanking(unlimited.documents, search_server.FindTopDocuments(query), 1e-9));
+            CHECK(IsSameRanking(search_server.FindTopDocumentsWithin(query, odd_ids, QueryOptions{}).documents,
+                search_server.FindTopDocuments(query, odd_ids), 1e-9));
+
+            // Full relevances of all the matched documents
+            map<int, double> relevances;
+            for (const Document& document : search_server.FindTopDocumentsAfter(query, nullopt, test_corpus.corpus.documents.size()))
+            {
+                relevances[document.id] = document.relevance;
+            }
+            for (const size_t posting_budget : { 1, 50, 300, 1000 })
+            {
+                const SearchResult result = search_server.FindTopDocumentsWithin(query, MakeBudget(posting_budget));
+                CHECK(result.scored_postings == min(posting_budget, unlimited.scored_postings));
+                CHECK(result.is_partial == (posting_budget < unlimited.scored_postings));
+                for (const Document& document : result.documents)
+                {
+                    // Partial relevances are parts of the full ones; documents excluded by minus words stay excluded
+                    CHECK(relevances.count(document.id) && document.relevance <= relevances[document.id] + 1e-9);
+                }
+            }
+        }
+
+        // Async runs the same search on the pool of the server
+        for (size_t i = 0; i < test_corpus.queries.size(); i += 30)
+        {
+            const string& query = test_corpus.queries[i];
+            const SearchResult result = search_server.FindTopDocumentsAsync(query, DocumentStatus::BANNED, MakeBudget(200)).get();
+            const SearchResult expected = search_server.FindTopDocumentsWithin(query, DocumentStatus::BANNED, MakeBudget(200));
+            CHECK(IsSameRanking(result.documents, expected.documents, 0.0));
+            CHECK(result.is_partial == expected.is_partial && result.scored_postings == expected.scored_postings);
+        }
+
+        QueryOptions cancelled;
+        cancelled.cancellation.Cancel();
+        const SearchResult cancelled_result = search_server.FindTopDocumentsAsync(test_corpus.queries[0], cancelled).get();
+        CHECK(cancelled_result.is_partial && cancelled_result.documents.empty() && cancelled_result.scored_postings == 0);
+
+        QueryOptions expired;
+        expired.deadline = chrono::steady_clock::now();
+        const SearchResult expired_result = search_server.FindTopDocumentsWithin(test_corpus.queries[0], expired);
+        CHECK(expired_result.is_partial && expired_result.documents.empty());
+    }
+}
+
+int main()
+{
+    TestQueryBudget();
+    TestBudgetWithinFirstBlock();
+    TestCorpusBudgets(MakeTestCorpus());
+    return ReportChecks();
+}
@@ -0,0 +1,142 @@
+// RemoveDocument and RemoveDocuments (seq and par) leave the same index as adding only the kept documents,
+// and words no document contains any more leave the index, so memory stays bounded under churn.
+// Build from the repository root:
+//     g++ -std=c++17 -O2 -I search-server -I tests tests/remove_documents_tests.cpp $(ls search-server/*.cpp | grep -v main.cpp) -ltbb -lpthread -o remove_documents_tests
+
+#include "memory_usage.h"
+#include "search_server.h"
+#include "test_helpers.h"
+
+#include <execution>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    using WordMap = map<string_view, double>;
+
+    void CheckSameIndex(const SearchServer& search_server, const SearchServer& reference, const vector<string>& queries)
+    {
+        CHECK(vector<int>(search_server.begin(), search_server.end()) == vector<int>(reference.begin(), reference.end()));
+        for (const int document_id : search_server)
+        {
+            CHECK(WordMap(search_server.GetWordFrequencies(document_id)) == WordMap(reference.GetWordFrequencies(document_id)));
+        }
+        for (const string& query : queries)
+        {
+            CHECK(IsSameRanking(search_server.FindTopDocuments(execution::seq, query), reference.FindTopDocuments(execution::seq, query), 0.0));
+        }
+        const MemoryUsage usage = search_server.GetMemoryUsage();
+        const MemoryUsage reference_usage = reference.GetMemoryUsage();
+        CHECK(usage.forward_index == reference_usage.forward_index && usage.document_metadata == reference_usage.document_metadata);
+    }
+
+    void TestBatchRemoval(const TestCorpus& test_corpus)
+    {
+        SearchServer kept_documents(test_corpus.corpus.stop_words, MakeServerOptions(2));
+        vector<int> removed_ids;
+        for (const SyntheticDocument& document : test_corpus.corpus.documents)
+        {
+            if (IsRemoved(document.id))
+            {
+                removed_ids.push_back(document.id);
+            }
+            else
+            {
+                kept_documents.AddDocument(document.id, document.text, document.status, document.ratings);
+            }
+        }
+        // Unknown and repeated ids are skipped
+        vector<int> requested_ids = removed_ids;
+        requested_ids.push_back(-1);
+        requested_ids.push_back(removed_ids.front());
+
+        SearchServer one_by_one(test_corpus.corpus.stop_words, MakeServerOptions(2));
+        SearchServer seq_batch(test_corpus.corpus.stop_words, MakeServerOptions(2));
+        SearchServer par_batch(test_corpus.corpus.stop_words, MakeServerOptions(4));
+        for (SearchServer* search_server : { &one_by_one, &seq_batch, &par_batch })
+        {
+            AddDocuments(*search_server, test_corpus.corpus);
+        }
+        for (const int document_id : requested_ids)
+        {
+            one_by_one.RemoveDocument(document_id);
+        }
+        seq_batch.RemoveDocuments(execution::seq, requested_ids);
+        par_batch.RemoveDocuments(execution::par, requested_ids);
+        for (const SearchServer* search_server : { &one_by_one, &seq_batch, &par_batch })
+        {
+            CheckSameIndex(*search_server, kept_documents, test_corpus.queries);
+        }
+        CHECK(seq_batch.GetMemoryUsage().postings == par_batch.GetMemoryUsage().postings);
+    }
+
+    void TestEmptyWords()
+    {
+        SearchServer search_server("and in"s, MakeServerOptions(2));
+        search_server.AddDocument(1, "white cat and collar"s, DocumentStatus::ACTUAL, { 1 });
+        search_server.AddDocument(2, "fluffy cat"s, DocumentStatus::ACTUAL, { 2 });
+        const MemoryUsage two_documents = search_server.GetMemoryUsage();
+        search_server.RemoveDocument(1);
+        CHECK(search_server.FindTopDocuments("collar"s).empty());
+        CHECK(search_server.FindTopDocuments("white -fluffy"s).empty());
+        CHECK(search_server.FindTopDocuments("cat"s).size() == 1);
+
+        // The words come back with a document that has them
+        search_server.AddDocument(3, "white collar"s, DocumentStatus::ACTUAL, { 3 });
+        CHECK(search_server.FindTopDocuments("collar"s).size() == 1);
+        const auto [words, status] = search_server.MatchDocument("white collar cat"s, 3);
+        CHECK((words == vector<string_view>{ "collar"sv, "white"sv }));
+
+        search_server.RemoveDocuments({ 2, 3 });
+        const MemoryUsage empty = search_server.GetMemoryUsage();
+        CHECK(empty.postings == 0 && empty.forward_index == 0 && empty.document_metadata == 0);
+        CHECK(empty.dictionary < two_documents.dictionary);
+        CHECK(search_server.FindTopDocuments("cat"s).empty());
+    }
+
+    // Every round adds documents with words no other round uses and removes them again
+    void TestChurn()
+    {
+        SearchServer search_server("and in"s, MakeServerOptions(2));
+        search_server.AddDocument(0, "stable words of the index"s, DocumentStatus::ACTUAL, { 1 });
+        MemoryUsage first_round;
+        for (int round = 0; round < 20; ++round)
+        {
+            vector<int> round_ids;
+            for (int i = 1; i <= 200; ++i)
+            {
+                const int document_id = round * 1000 + i;
+                search_server.AddDocument(document_id, "round"s + to_string(round) + "word"s + to_string(i) + " stable words"s,
+                    DocumentStatus::ACTUAL, { i });
+                round_ids.push_back(document_id);
+            }
+            CHECK(search_server.FindTopDocuments("round"s + to_string(round) + "word7"s).size() == 1);
+            search_server.RemoveDocuments(execution::par, round_ids);
+            CHECK(search_server.FindTopDocuments("round"s + to_string(round) + "word7"s).empty());
+            const MemoryUsage usage = search_server.GetMemoryUsage();
+            if (round == 0)
+            {
+                first_round = usage;
+            }
+            // Ids and strings of the dropped words are reused by the next round
+            CHECK(usage.dictionary == first_round.dictionary);
+            CHECK(usage.postings == first_round.postings && usage.forward_index == first_round.forward_index);
+        }
+        CHECK(search_server.GetDocumentCount() == 1);
+        CHECK(search_server.FindTopDocuments("stable"s).size() == 1);
+    }
+}
+
+int main()
+{
+    const TestCorpus test_corpus = MakeTestCorpus();
+    TestBatchRemoval(test_corpus);
+    TestEmptyWords();
+    TestChurn();
+    return ReportChecks();
+}
@@ -0,0 +1,164 @@
+// Scoring kernels: the AVX2 and AVX-512 code sums exactly what the scalar code does, in double and in float,
+// and ScorePrecision::FLOAT stays within its error bound of the DOUBLE relevances.
+// Kernels the CPU lacks are skipped.
+// Build from the repository root:
+//     g++ -std=c++17 -O2 -I search-server -I tests tests/scoring_kernel_tests.cpp $(ls search-server/*.cpp | grep -v main.cpp) -ltbb -lpthread -o scoring_kernel_tests
+
+#include "scoring_kernel.h"
+#include "search_server.h"
+#include "test_helpers.h"
+
+#include <algorithm>
+#include <cmath>
+#include <execution>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    struct ScoringBlock
+    {
+        vector<int> document_ids;
+        vector<double> term_freqs;
+    };
+
+    // Distinct ids in a random order, as in a block of postings
+    ScoringBlock MakeBlock(mt19937& random, size_t count, int base, size_t span)
+    {
+        vector<int> slots(span);
+        iota(slots.begin(), slots.end(), base);
+        shuffle(slots.begin(), slots.end(), random);
+        ScoringBlock block;
+        block.document_ids.assign(slots.begin(), slots.begin() + count);
+        uniform_int_distribution<int> word_count(1, 50);
+        for (size_t i = 0; i < count; ++i)
+        {
+            block.term_freqs.push_back(word_count(random) / static_cast<double>(word_count(random) + 50));
+        }
+        return block;
+    }
+
+    template <typename Score>
+    vector<Score> Accumulate(ScoringKernel kernel, const vector<ScoringBlock>& blocks, int base, size_t span, Score weight)
+    {
+        vector<Score> scores(span, Score{ 0 });
+        for (const ScoringBlock& block : blocks)
+        {
+            AccumulateScoresWith(kernel, block.document_ids.data(), block.term_freqs.data(), block.document_ids.size(), base, weight, scores.data());
+        }
+        return scores;
+    }
+
+    template <typename Score>
+    vector<Score> AccumulateChosen(const vector<ScoringBlock>& blocks, int base, size_t span, Score weight)
+    {
+        vector<Score> scores(span, Score{ 0 });
+        for (const ScoringBlock& block : blocks)
+        {
+            AccumulateScores(block.document_ids.data(), block.term_freqs.data(), block.document_ids.size(), base, weight, scores.data());
+        }
+        return scores;
+    }
+
+    void TestKernelsAgree()
+    {
+        mt19937 random(41);
+        constexpr int BASE = 1000;
+        constexpr size_t SPAN = 4096;
+        // Sizes around the vector widths, and ids reaching both ends of the span
+        vector<ScoringBlock> blocks;
+        for (const size_t count : { 0, 1, 3, 4, 7, 8, 9, 15, 16, 17, 31, 33, 128, 1000, 4096 })
+        {
+            blocks.push_back(MakeBlock(random, count, BASE, SPAN));
+        }
+        const double double_weight = 1.7320508075688772;
+        const float float_weight = static_cast<float>(double_weight);
+        const vector<double> scalar_doubles = Accumulate(ScoringKernel::SCALAR, blocks, BASE, SPAN, double_weight);
+        const vector<float> scalar_floats = Accumulate(ScoringKernel::SCALAR, blocks, BASE, SPAN, float_weight);
+        CHECK(IsScoringKernelSupported(ScoringKernel::SCALAR));
+        CHECK(AccumulateChosen(blocks, BASE, SPAN, double_weight) == scalar_doubles);
+        CHECK(AccumulateChosen(blocks, BASE, SPAN, float_weight) == scalar_floats);
+        for (const ScoringKernel kernel : { ScoringKernel::AVX2, ScoringKernel::AVX512 })
+        {
+            if (!IsScoringKernelSupported(kernel))
+            {
+                cerr << "Kernel " << static_cast<int>(kernel) << " is not supported by the CPU, skipped" << endl;
+                continue;
+            }
+            // Bit for bit, not within a tolerance
+            CHECK(Accumulate(kernel, blocks, BASE, SPAN, double_weight) == scalar_doubles);
+            CHECK(Accumulate(kernel, blocks, BASE, SPAN, float_weight) == scalar_floats);
+        }
+
+        // Every slot got the sum of its postings
+        vector<double> expected(SPAN, 0.0);
+        for (const ScoringBlock& block : blocks)
+        {
+            for (size_t i = 0; i < block.document_ids.size(); ++i)
+            {
+                expected[block.document_ids[i] - BASE] += block.term_freqs[i] * double_weight;
+            }
+        }
+        CHECK(expected == scalar_doubles);
+    }
+
+    size_t CountWords(const string& query)
+    {
+        return static_cast<size_t>(count(query.begin(), query.end(), ' ')) + 1;
+    }
+
+    void TestFloatPrecision(const TestCorpus& test_corpus)
+    {
+        SearchServerOptions float_options = MakeServerOptions(2);
+        float_options.score_precision = ScorePrecision::FLOAT;
+        SearchServer double_server(test_corpus.corpus.stop_words, MakeServerOptions(2));
+        SearchServer float_server(test_corpus.corpus.stop_words, float_options);
+        AddDocuments(double_server, test_corpus.corpus);
+        AddDocuments(float_server, test_corpus.corpus);
+
+        size_t reordered_queries = 0;
+        size_t rounded_relevances = 0;
+        for (const string& query : test_corpus.queries)
+        {
+            const vector<Document> double_documents = double_server.FindTopDocuments(execution::seq, query);
+            const vector<Document> float_documents = float_server.FindTopDocuments(execution::seq, query);
+            CHECK(double_documents.size() == float_documents.size());
+            // Three roundings per term and one per addition, each at most 2^-24 relative
+            const double relative_error = CountWords(query) * ldexp(1.0, -22);
+            bool is_reordered = false;
+            for (size_t i = 0; i < min(double_documents.size(), float_documents.size()); ++i)
+            {
+                const Document& expected = double_documents[i];
+                const Document& document = float_documents[i];
+                if (document.id == expected.id)
+                {
+                    CHECK(abs(document.relevance - expected.relevance) <= relative_error * expected.relevance);
+                    rounded_relevances += document.relevance != expected.relevance;
+                }
+                else
+                {
+                    // Another document may take the place only if the two nearly tie
+                    is_reordered = true;
+                    CHECK(abs(document.relevance - expected.relevance) <= 2 * COMPARISON_ACCURACY);
+                }
+            }
+            reordered_queries += is_reordered;
+        }
+        // The dense float accumulators were used at all
+        CHECK(rounded_relevances > 0);
+        CHECK(reordered_queries * 20 < test_corpus.queries.size());
+    }
+}
+
+int main()
+{
+    TestKernelsAgree();
+    const TestCorpus test_corpus = MakeTestCorpus();
+    TestFloatPrecision(test_corpus);
+    return ReportChecks();
+}
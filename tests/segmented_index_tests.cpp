@@ -0,0 +1,125 @@
+// SegmentedIndex against SearchServer, with removals during the background merges and after Optimize,
+// and the query and word rules the two share.
+// Build from the repository root:
+//     g++ -std=c++17 -O2 -I search-server -I tests tests/segmented_index_tests.cpp $(ls search-server/*.cpp | grep -v main.cpp) -ltbb -lpthread -o segmented_index_tests
+
+#include "query_parser.h"
+#include "search_server.h"
+#include "segmented_index.h"
+#include "test_helpers.h"
+
+#include <algorithm>
+#include <execution>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    bool IsWords(const vector<string_view>& words, const vector<string>& expected)
+    {
+        return equal(words.begin(), words.end(), expected.begin(), expected.end());
+    }
+
+    void TestQueryParser()
+    {
+        const StopWords stop_words = MakeStopWords(vector<string>{ "in"s, "the"s, ""s, "in"s });
+        CHECK(stop_words.size() == 2);
+        CHECK(Throws<invalid_argument>([] { MakeStopWords(vector<string>{ "a\x01b"s }); }));
+
+        const string text = "cat in -the dog -tail cat -fur"s;
+        const ParsedQuery query = ParseQueryText(text, stop_words);
+        CHECK(IsWords(query.plus_words, { "cat"s, "dog"s }));
+        CHECK(IsWords(query.minus_words, { "tail"s, "fur"s }));
+        CHECK(ParseQueryText(""s, stop_words).plus_words.empty());
+        for (const string& invalid_query : { "cat -"s, "cat --dog"s, "ca\x12t"s })
+        {
+            CHECK(Throws<invalid_argument>([&] { ParseQueryText(invalid_query, stop_words); }));
+        }
+        const string document = "the cat in the hat"s;
+        CHECK(IsWords(SplitIntoWordsNoStop(document, stop_words), { "cat"s, "hat"s }));
+
+        CHECK(ComputeAverageRating({}) == 0);
+        CHECK(ComputeAverageRating({ 1, 2, 4 }) == 2);
+        CHECK(ComputeAverageRating({ -5, 2 }) == -1);
+    }
+
+    // Both engines reject the same queries and stop words
+    void TestSameErrors()
+    {
+        SearchServer search_server("and"s, MakeServerOptions(0));
+        SegmentedIndex segmented_index("and"s);
+        search_server.AddDocument(1, "cat and dog"s, DocumentStatus::ACTUAL, { 1 });
+        segmented_index.AddDocument(1, "cat and dog"s, DocumentStatus::ACTUAL, { 1 });
+        for (const string& invalid_query : { "cat -"s, "cat --dog"s, "ca\x12t"s })
+        {
+            CHECK(Throws<invalid_argument>([&] { search_server.FindTopDocuments(invalid_query); }));
+            CHECK(Throws<invalid_argument>([&] { segmented_index.FindTopDocuments(invalid_query); }));
+        }
+        CHECK(Throws<invalid_argument>([] { SearchServer("a\x01b"s); }));
+        CHECK(Throws<invalid_argument>([] { SegmentedIndex("a\x01b"s); }));
+        // A stop word used as a minus word is dropped before the minus word is checked
+        CHECK(IsSameRanking(segmented_index.FindTopDocuments("cat -and"s), search_server.FindTopDocuments("cat -and"s), 0.0));
+    }
+
+    void TestSegmentedIndex(const TestCorpus& test_corpus)
+    {
+        SearchServer search_server(test_corpus.corpus.stop_words, MakeServerOptions(0));
+        SegmentedIndexOptions options;
+        options.segment_size = 300;
+        options.thread_count = 2;
+        SegmentedIndex segmented_index(test_corpus.corpus.stop_words, options);
+        // Removals interleaved with additions run while the background merges of earlier segments do
+        for (const SyntheticDocument& document : test_corpus.corpus.documents)
+        {
+            search_server.AddDocument(document.id, document.text, document.status, document.ratings);
+            segmented_index.AddDocument(document.id, document.text, document.status, document.ratings);
+            const int removed_id = document.id - 150;
+            if (removed_id >= 0 && IsRemoved(removed_id))
+            {
+                search_server.RemoveDocument(removed_id);
+                segmented_index.RemoveDocument(removed_id);
+            }
+        }
+        for (int removed_id = max(0, static_cast<int>(test_corpus.corpus.documents.size()) - 150);
+            removed_id < static_cast<int>(test_corpus.corpus.documents.size()); ++removed_id)
+        {
+            if (IsRemoved(removed_id))
+            {
+                search_server.RemoveDocument(removed_id);
+                segmented_index.RemoveDocument(removed_id);
+            }
+        }
+        CHECK(segmented_index.GetDocumentCount() == search_server.GetDocumentCount());
+
+        auto check_queries = [&]
+        {
+            for (const string& query : test_corpus.queries)
+            {
+                // Per-segment sums may round differently from the whole-index ones
+                const vector<Document> expected = search_server.FindTopDocuments(execution::seq, query);
+                CHECK(IsSameRanking(segmented_index.FindTopDocuments(query), expected, 1e-9));
+                CHECK(IsSameRanking(segmented_index.FindTopDocuments(execution::par, query), expected, 1e-9));
+                CHECK(IsSameRanking(segmented_index.FindTopDocuments(query, DocumentStatus::BANNED),
+                    search_server.FindTopDocuments(execution::seq, query, DocumentStatus::BANNED), 1e-9));
+            }
+        };
+        check_queries();
+        segmented_index.WaitForMerges();
+        check_queries();
+        segmented_index.Optimize(DocumentOrder::LOCALITY);
+        CHECK(segmented_index.GetStats().segment_count == 1);
+        CHECK(segmented_index.GetStats().deleted_document_count == 0);
+        check_queries();
+    }
+}
+
+int main()
+{
+    TestQueryParser();
+    TestSameErrors();
+    TestSegmentedIndex(MakeTestCorpus());
+    return ReportChecks();
+}
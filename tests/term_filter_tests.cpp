@@ -0,0 +1,143 @@
+// TermFilter: no false negatives, and the false positive rate it estimates is the one measured on unknown
+// words; TermDictionary rebuilds it from the words it still has, so removals shrink it again.
+// Build from the repository root:
+//     g++ -std=c++17 -O2 -I search-server -I tests tests/term_filter_tests.cpp $(ls search-server/*.cpp | grep -v main.cpp) -ltbb -lpthread -o term_filter_tests
+
+#include "search_server.h"
+#include "term_dictionary.h"
+#include "term_filter.h"
+#include "test_helpers.h"
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    string MakeWord(const string& prefix, size_t i)
+    {
+        return prefix + to_string(i);
+    }
+
+    double MeasureFalsePositiveRate(const TermFilter& filter)
+    {
+        constexpr size_t UNKNOWN_WORD_COUNT = 200000;
+        size_t false_positives = 0;
+        for (size_t i = 0; i < UNKNOWN_WORD_COUNT; ++i)
+        {
+            false_positives += filter.MayContain(MakeWord("unknown"s, i));
+        }
+        return static_cast<double>(false_positives) / UNKNOWN_WORD_COUNT;
+    }
+
+    void TestTermFilter()
+    {
+        const TermFilter empty(1000);
+        CHECK(empty.GetCapacity() >= 1000 && empty.GetTermCount() == 0);
+        CHECK(!empty.MayContain("word"s) && !empty.MayContain(""s));
+        CHECK(empty.GetStats().false_positive_rate == 0.0);
+
+        TermFilter filter(10000);
+        for (size_t i = 0; i < 10000; ++i)
+        {
+            filter.Add(MakeWord("known"s, i));
+        }
+        bool has_false_negative = false;
+        for (size_t i = 0; i < 10000; ++i)
+        {
+            has_false_negative |= !filter.MayContain(MakeWord("known"s, i));
+        }
+        CHECK(!has_false_negative);
+        const TermFilter::Stats stats = filter.GetStats();
+        CHECK(stats.term_count == 10000);
+        CHECK(stats.byte_size <= filter.GetMemoryBytes());
+        // About 0.5% at capacity; the estimate is within sampling noise of the rate on unknown words
+        const double measured_rate = MeasureFalsePositiveRate(filter);
+        CHECK(stats.false_positive_rate > 0.001 && stats.false_positive_rate < 0.01);
+        CHECK(abs(measured_rate - stats.false_positive_rate) < 0.2 * stats.false_positive_rate + 0.0005);
+
+        // Past its capacity the filter still has no false negatives, but the rate grows
+        for (size_t i = 10000; i < 30000; ++i)
+        {
+            filter.Add(MakeWord("known"s, i));
+        }
+        const TermFilter::Stats overfull_stats = filter.GetStats();
+        CHECK(overfull_stats.false_positive_rate > 10 * stats.false_positive_rate);
+        CHECK(abs(MeasureFalsePositiveRate(filter) - overfull_stats.false_positive_rate) < 0.2 * overfull_stats.false_positive_rate);
+        CHECK(filter.MayContain(MakeWord("known"s, 29999)));
+    }
+
+    void TestDictionaryFilter()
+    {
+        TermDictionary dictionary;
+        const size_t initial_bytes = dictionary.GetFilterStats().byte_size;
+        vector<int> term_ids;
+        for (size_t i = 0; i < 50000; ++i)
+        {
+            term_ids.push_back(dictionary.AddTerm(MakeWord("word"s, i)));
+        }
+        CHECK(dictionary.AddTerm("word7"s) == term_ids[7]);
+        const TermFilter::Stats full_stats = dictionary.GetFilterStats();
+        CHECK(full_stats.term_count == 50000 && full_stats.byte_size > initial_bytes);
+        CHECK(full_stats.false_positive_rate < 0.01);
+
+        // Keep every tenth word
+        for (size_t i = 0; i < term_ids.size(); ++i)
+        {
+            if (i % 10 != 0)
+            {
+                dictionary.RemoveTerm(term_ids[i]);
+            }
+        }
+        CHECK(dictionary.GetTermCount() == 5000);
+        const TermFilter::Stats kept_stats = dictionary.GetFilterStats();
+        CHECK(kept_stats.term_count < 2 * 5000 && kept_stats.byte_size < full_stats.byte_size / 4);
+        CHECK(kept_stats.false_positive_rate < 0.01);
+        bool is_found_right = true;
+        for (size_t i = 0; i < term_ids.size(); ++i)
+        {
+            const int term_id = dictionary.FindTerm(MakeWord("word"s, i));
+            is_found_right &= i % 10 == 0 ? term_id == term_ids[i] && dictionary.GetTerm(term_id) == MakeWord("word"s, i)
+                : term_id == TermDictionary::NO_TERM;
+        }
+        CHECK(is_found_right);
+
+        // New words take the ids of the removed ones
+        const int new_id = dictionary.AddTerm("new"s);
+        CHECK(new_id < 50000 && new_id % 10 != 0);
+        CHECK(dictionary.FindTerm("new"s) == new_id && dictionary.MayContain("new"s));
+
+        for (size_t i = 0; i < term_ids.size(); i += 10)
+        {
+            dictionary.RemoveTerm(term_ids[i]);
+        }
+        dictionary.RemoveTerm(new_id);
+        CHECK(dictionary.GetTermCount() == 0);
+        CHECK(dictionary.GetFilterStats().byte_size == initial_bytes);
+    }
+
+    void TestServerFilter(const TestCorpus& test_corpus)
+    {
+        SearchServer search_server(test_corpus.corpus.stop_words, MakeServerOptions(2));
+        const TermFilter::Stats empty_stats = search_server.GetTermFilterStats();
+        AddDocuments(search_server, test_corpus.corpus);
+        const TermFilter::Stats full_stats = search_server.GetTermFilterStats();
+        CHECK(full_stats.byte_size > empty_stats.byte_size);
+        vector<int> document_ids(search_server.begin(), search_server.end());
+        search_server.RemoveDocuments(document_ids);
+        const TermFilter::Stats removed_stats = search_server.GetTermFilterStats();
+        // A filter of the smallest size keeps the bits of removed words until it fills up
+        CHECK(removed_stats.term_count < full_stats.term_count && removed_stats.byte_size == empty_stats.byte_size);
+    }
+}
+
+int main()
+{
+    TestTermFilter();
+    TestDictionaryFilter();
+    const TestCorpus test_corpus = MakeTestCorpus();
+    TestServerFilter(test_corpus);
+    return ReportChecks();
+}
@@ -0,0 +1,108 @@
+#pragma once
+// Checks shared by the test executables: every one prints the failed checks and exits with 1 if there are any
+
+#include "document.h"
+#include "search_server.h"
+#include "synthetic_corpus.h"
+
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+inline size_t failed_checks = 0;
+
+#define CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            ++failed_checks; \
+            std::cerr << __FILE__ << ':' << __LINE__ << ": CHECK(" << #condition << ") failed" << std::endl; \
+        } \
+    } while (false)
+
+// Whether function() throws Exception
+template <typename Exception, typename Function>
+bool Throws(Function function)
+{
+    try
+    {
+        function();
+    }
+    catch (const Exception&)
+    {
+        return true;
+    }
+    return false;
+}
+
+// Exit code of main
+inline int ReportChecks()
+{
+    if (failed_checks > 0)
+    {
+        std::cerr << failed_checks << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cerr << "All tests passed" << std::endl;
+    return 0;
+}
+
+// Same documents in the same order with relevances closer than accuracy
+inline bool IsSameRanking(const std::vector<Document>& lhs, const std::vector<Document>& rhs, double accuracy)
+{
+    if (lhs.size() != rhs.size())
+    {
+        return false;
+    }
+    for (size_t i = 0; i < lhs.size(); ++i)
+    {
+        if (lhs[i].id != rhs[i].id || lhs[i].rating != rhs[i].rating || std::abs(lhs[i].relevance - rhs[i].relevance) > accuracy)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+struct TestCorpus
+{
+    SyntheticCorpus corpus;
+    std::vector<std::string> queries;
+};
+
+inline TestCorpus MakeTestCorpus()
+{
+    CorpusConfig corpus_config;
+    corpus_config.document_count = 4000;
+    corpus_config.vocabulary_size = 3000;
+    corpus_config.topic_count = 8;
+    QueryConfig query_config;
+    query_config.query_count = 300;
+    TestCorpus test_corpus;
+    test_corpus.corpus = GenerateCorpus(corpus_config);
+    test_corpus.queries = GenerateQueries(test_corpus.corpus, query_config);
+    return test_corpus;
+}
+
+inline SearchServerOptions MakeServerOptions(size_t thread_count)
+{
+    SearchServerOptions options;
+    options.thread_count = thread_count;
+    return options;
+}
+
+inline void AddDocuments(SearchServer& search_server, const SyntheticCorpus& corpus)
+{
+    for (const SyntheticDocument& document : corpus.documents)
+    {
+        search_server.AddDocument(document.id, document.text, document.status, document.ratings);
+    }
+}
+
+// The documents removed by the tests
+inline bool IsRemoved(int document_id)
+{
+    return document_id % 5 == 2;
+}
@@ -0,0 +1,147 @@
+// ThreadPool: ParallelFor runs every index once, nested calls finish on a small pool, idle workers steal,
+// exceptions reach the caller, the destructor finishes the queue and the stats add up.
+// Build from the repository root:
+//     g++ -std=c++17 -O2 -I search-server -I tests tests/thread_pool_tests.cpp $(ls search-server/*.cpp | grep -v main.cpp) -ltbb -lpthread -o thread_pool_tests
+
+#include "thread_pool.h"
+#include "test_helpers.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    uint64_t CountExecutedTasks(const ThreadPool::Stats& stats)
+    {
+        uint64_t executed_tasks = stats.caller_executed_tasks;
+        for (const ThreadPool::WorkerStats& worker : stats.workers)
+        {
+            executed_tasks += worker.executed_tasks;
+        }
+        return executed_tasks;
+    }
+
+    void TestParallelFor()
+    {
+        for (const size_t thread_count : { 0, 1, 4 })
+        {
+            ThreadPool thread_pool(thread_count);
+            CHECK(thread_pool.GetThreadCount() == thread_count);
+            for (const size_t count : { 0, 1, 2, 7, 1000 })
+            {
+                vector<atomic<int>> calls(count + 10);
+                thread_pool.ParallelFor(10, 10 + count, [&calls](size_t i) { ++calls[i]; });
+                CHECK(all_of(calls.begin(), calls.begin() + 10, [](const atomic<int>& call) { return call == 0; }));
+                CHECK(all_of(calls.begin() + 10, calls.end(), [](const atomic<int>& call) { return call == 1; }));
+            }
+            // An empty range
+            thread_pool.ParallelFor(5, 3, [](size_t) { CHECK(!"called for an empty range"); });
+
+            // Every task submitted by ParallelFor has run by the time it returns
+            const ThreadPool::Stats stats = thread_pool.GetStats();
+            CHECK(stats.workers.size() == thread_count);
+            CHECK(CountExecutedTasks(stats) == stats.submitted_tasks);
+            if (thread_count == 0)
+            {
+                CHECK(stats.caller_executed_tasks == stats.submitted_tasks);
+            }
+            CHECK(stats.GetUtilization() >= 0.0 && stats.GetUtilization() <= 1.0);
+        }
+    }
+
+    void TestNestedParallelFor()
+    {
+        // Three levels on two threads: the waiting threads run the inner chunks instead of blocking
+        ThreadPool thread_pool(2);
+        vector<atomic<int>> calls(8 * 8 * 8);
+        thread_pool.ParallelFor(0, 8, [&](size_t i)
+        {
+            thread_pool.ParallelFor(0, 8, [&](size_t j)
+            {
+                thread_pool.ParallelFor(0, 8, [&](size_t k) { ++calls[(i * 8 + j) * 8 + k]; });
+            });
+        });
+        CHECK(all_of(calls.begin(), calls.end(), [](const atomic<int>& call) { return call == 1; }));
+
+        // From inside a pool task
+        auto future = thread_pool.Async([&thread_pool]
+        {
+            atomic<size_t> sum = 0;
+            thread_pool.ParallelFor(0, 100, [&sum](size_t i) { sum += i; });
+            return sum.load();
+        });
+        CHECK(future.get() == 4950);
+    }
+
+    void TestStealing()
+    {
+        ThreadPool thread_pool(2);
+        // The chunks of a ParallelFor started on a worker go to its own deque, only the other worker can take them
+        thread_pool.Async([&thread_pool]
+        {
+            thread_pool.ParallelFor(0, 12, [](size_t) { this_thread::sleep_for(chrono::milliseconds(5)); });
+        }).get();
+        const ThreadPool::Stats stats = thread_pool.GetStats();
+        uint64_t stolen_tasks = 0;
+        for (const ThreadPool::WorkerStats& worker : stats.workers)
+        {
+            stolen_tasks += worker.stolen_tasks;
+            CHECK(worker.stolen_tasks <= worker.executed_tasks);
+        }
+        CHECK(stolen_tasks > 0);
+        CHECK(stats.caller_executed_tasks == 0);
+        CHECK(stats.workers[0].busy_time.count() + stats.workers[1].busy_time.count() > 0);
+    }
+
+    void TestExceptions()
+    {
+        for (const size_t thread_count : { 0, 3 })
+        {
+            ThreadPool thread_pool(thread_count);
+            CHECK(Throws<runtime_error>([&]
+            {
+                thread_pool.ParallelFor(0, 100, [](size_t i)
+                {
+                    if (i == 57)
+                    {
+                        throw runtime_error("chunk");
+                    }
+                });
+            }));
+            auto future = thread_pool.Async([]() -> int { throw logic_error("task"); });
+            CHECK(Throws<logic_error>([&] { future.get(); }));
+            // The pool keeps working
+            CHECK(thread_pool.Async([] { return 42; }).get() == 42);
+        }
+    }
+
+    void TestDestructorFinishesQueue()
+    {
+        atomic<int> executed = 0;
+        {
+            ThreadPool thread_pool(2);
+            for (int i = 0; i < 200; ++i)
+            {
+                thread_pool.Submit([&executed] { ++executed; });
+            }
+        }
+        CHECK(executed == 200);
+    }
+}
+
+int main()
+{
+    TestParallelFor();
+    TestNestedParallelFor();
+    TestStealing();
+    TestExceptions();
+    TestDestructorFinishesQueue();
+    return ReportChecks();
+}